@@ -0,0 +1,86 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// bench_util.h
+// Helpers shared by the stand alone benchmarks in this directory.
+// There is no associated source file.
+
+#ifndef FILE_BENCH_UTIL_H_INCLUDED
+#define FILE_BENCH_UTIL_H_INCLUDED
+
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+
+#include "../lib/synthetic_kinect.h"
+#include "../lib/depth_codec.h"
+#include "../lib/kinect_recording.h"
+
+const int BENCH_WIDTH = 640;
+const int BENCH_HEIGHT = 480;
+const uint16_t BENCH_INVALID_DEPTH = 2047;
+
+// Monotonic time in nanoseconds.
+inline uint64_t benchNanos()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+// Fill frame with a synthetic BENCH_WIDTH x BENCH_HEIGHT disparity image,
+// see synthetic_kinect.h.
+inline void makeSyntheticDepthFrame(std::vector<uint16_t> &frame, unsigned frame_index)
+{
+    makeSyntheticDepthFrame(frame, BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH, frame_index);
+}
+
+// Loads the depth frames of a recording made with --record, decoding
+// compressed ones. Returns false if there are none.
+inline bool loadRecordedDepth(const char *path, std::vector< std::vector<uint16_t> > &frames)
+{
+    const size_t frame_bytes = BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint16_t);
+    kinect_archive archive;
+    if (!archive.open(path) ||
+        archive.width() != BENCH_WIDTH || archive.height() != BENCH_HEIGHT)
+        return false;
+
+    depth_codec codec(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+    for (size_t i = 0; i < archive.size(); ++i) {
+        const kinect_chunk &chunk = archive.chunk(i);
+        const uint8_t *payload = archive.payload(i);
+        if (!payload)
+            continue;
+        if (chunk.type == KINECT_DEPTH_CHUNK && chunk.bytes == frame_bytes) {
+            const uint16_t *depth = reinterpret_cast<const uint16_t*>(payload);
+            frames.push_back(std::vector<uint16_t>(depth, depth + BENCH_WIDTH * BENCH_HEIGHT));
+        } else if (chunk.type == KINECT_DEPTH_CODEC_CHUNK) {
+            frames.push_back(std::vector<uint16_t>(BENCH_WIDTH * BENCH_HEIGHT));
+            if (!codec.decode(payload, chunk.bytes, &frames.back().front()))
+                frames.pop_back();
+        }
+    }
+    return !frames.empty();
+}
+
+#endif //#ifndef FILE_BENCH_UTIL_H_INCLUDED
@@ -0,0 +1,165 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// depth_bands_bench.cpp
+// Measures how the latency of converting one depth frame drops with the
+// number of threads, when the depth thread's stages are split into bands
+// of rows over a parallel_for: filtering, stride 2 vertices, compacted
+// triangles or NaN culled vertices, and copying a video frame. Checks the
+// banded output is identical to the single threaded functions'.
+// Frames come from a recording made with --record, or are synthetic if
+// none is given.
+//
+// Build (from this directory):
+//   g++ -O2 -msse2 -I../lib/LibOVR/Src depth_bands_bench.cpp -o depth_bands_bench -lpthread
+// Usage:
+//   ./depth_bands_bench [recording.krec]
+
+#include "bench_util.h"
+#include "../lib/depth_bands.h"
+#include "../lib/depth_worker.h"
+
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::setprecision;
+
+#include <vector>
+using std::vector;
+
+const int SYNTHETIC_FRAMES = 30;
+const int PASSES = 4;
+const float MAX_EDGE = .1f;
+
+int main(int argc, char **argv)
+{
+    vector< vector<uint16_t> > frames;
+    if (argc > 1 && argv[1][0]) {
+        if (!loadRecordedDepth(argv[1], frames)) {
+            cout << "No depth frames in " << argv[1] << endl;
+            return 1;
+        }
+        cout << frames.size() << " recorded frames from " << argv[1] << endl;
+    } else {
+        frames.resize(SYNTHETIC_FRAMES);
+        for (int i = 0; i < SYNTHETIC_FRAMES; ++i)
+            makeSyntheticDepthFrame(frames[i], i);
+        cout << frames.size() << " synthetic frames" << endl;
+    }
+
+    kinect_depth_tables tables(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+    depth_unprojector unprojector(tables, 2);
+    unsigned cols = unprojector.columns(), rows = unprojector.rowCount();
+    const unsigned pixels = BENCH_WIDTH * BENCH_HEIGHT;
+    const unsigned rgb_row = BENCH_WIDTH * 3;
+
+    // Single threaded reference of every stage, for every frame.
+    vector< vector<uint16_t> > ref_filtered(frames.size(), vector<uint16_t>(pixels));
+    vector< vector<float> > ref_culled(frames.size());
+    vector< vector<uint32_t> > ref_indices(frames.size());
+    {
+        depth_filter filter(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+        vector<float> vertices(unprojector.vertexCount() * 3);
+        for (size_t f = 0; f < frames.size(); ++f) {
+            filter.filter(&frames[f].front(), &ref_filtered[f].front());
+            unprojector.unproject(&ref_filtered[f].front(), &vertices.front());
+            ref_indices[f].resize(meshTriangleIndexCapacity(cols, rows));
+            ref_indices[f].resize(compactMeshTriangles(&vertices.front(), cols, rows,
+                                                       MAX_EDGE, &ref_indices[f].front()));
+            markCulledMeshVertices(&vertices.front(), cols, rows, MAX_EDGE);
+            ref_culled[f] = vertices;
+        }
+    }
+
+    int cores = depth_worker::coreCount();
+    cout << cores << " cores, stride 2, " << depth_bands::BAND_ROWS << " row bands" << endl;
+
+    // Powers of two, then every core.
+    vector<int> thread_counts;
+    for (int threads = 1; threads < cores; threads *= 2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(cores);
+
+    vector<uint8_t> rgb(pixels * 3, 128), rgb_copy(pixels * 3);
+    double single_ms = 0;
+    for (size_t t = 0; t < thread_counts.size(); ++t) {
+        int threads = thread_counts[t];
+        parallel_for pool(threads - 1);
+        depth_bands bands(pool);
+        vector<uint16_t> filtered(pixels);
+        vector<float> vertices(unprojector.vertexCount() * 3);
+        vector<uint32_t> indices(meshTriangleIndexCapacity(cols, rows));
+        uint64_t filter_ns = 0, unproject_ns = 0, compact_ns = 0, cull_ns = 0, copy_ns = 0;
+        bool identical = true;
+
+        for (int pass = 0; pass < PASSES; ++pass) {
+            // Every pass starts the filter's history over, like the reference.
+            depth_filter filter(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+            for (size_t f = 0; f < frames.size(); ++f) {
+                uint64_t start = benchNanos();
+                bands.filter(filter, &frames[f].front(), &filtered.front());
+                uint64_t filter_done = benchNanos();
+                bands.unproject(unprojector, &filtered.front(), &vertices.front());
+                uint64_t unproject_done = benchNanos();
+                unsigned count = bands.compactTriangles(&vertices.front(), cols, rows,
+                                                        MAX_EDGE, &indices.front());
+                uint64_t compact_done = benchNanos();
+                bands.markCulledVertices(&vertices.front(), cols, rows, MAX_EDGE);
+                uint64_t cull_done = benchNanos();
+                bands.copyRows(&rgb.front(), &rgb_copy.front(), rgb_row, BENCH_HEIGHT);
+                uint64_t copy_done = benchNanos();
+
+                filter_ns += filter_done - start;
+                unproject_ns += unproject_done - filter_done;
+                compact_ns += compact_done - unproject_done;
+                cull_ns += cull_done - compact_done;
+                copy_ns += copy_done - cull_done;
+
+                // NaNs never compare equal, so compare the bits.
+                identical = identical && filtered == ref_filtered[f] &&
+                            count == ref_indices[f].size() &&
+                            memcmp(&indices.front(), &ref_indices[f].front(),
+                                   count * sizeof(uint32_t)) == 0 &&
+                            memcmp(&vertices.front(), &ref_culled[f].front(),
+                                   vertices.size() * sizeof(float)) == 0;
+            }
+        }
+
+        double n = double(frames.size()) * PASSES * 1e6;
+        double total_ms = (filter_ns + unproject_ns + compact_ns + cull_ns + copy_ns) / n;
+        if (t == 0)
+            single_ms = total_ms;
+        cout << setprecision(3) << fixed << threads << " thread" << (threads > 1 ? "s: " : ":  ")
+             << filter_ns / n << " ms filter + " << unproject_ns / n << " ms unproject + "
+             << compact_ns / n << " ms compaction + " << cull_ns / n << " ms culling + "
+             << copy_ns / n << " ms video copy = " << total_ms << " ms/frame, "
+             << setprecision(2) << single_ms / total_ms << "x"
+             << (identical ? "" : " (OUTPUT DIFFERS)") << endl;
+        if (!identical)
+            return 1;
+    }
+    return 0;
+}
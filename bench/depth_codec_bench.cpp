@@ -0,0 +1,108 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// depth_codec_bench.cpp
+// Round trips depth frames through depth_codec, checks they come back
+// unchanged, and reports compression ratio and encode/decode MB/s of raw
+// depth. Frames come from a recording made with --record, or are synthetic
+// if none is given.
+//
+// Build (from this directory):
+//   g++ -O2 depth_codec_bench.cpp -o depth_codec_bench
+// Usage:
+//   ./depth_codec_bench [recording.krec] [passes]
+
+#include "bench_util.h"
+#include "../lib/depth_codec.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::setprecision;
+
+#include <vector>
+using std::vector;
+
+const int SYNTHETIC_FRAMES = 30;
+const size_t FRAME_BYTES = BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint16_t);
+
+int main(int argc, char **argv)
+{
+    vector< vector<uint16_t> > frames;
+    if (argc > 1) {
+        if (!loadRecordedDepth(argv[1], frames)) {
+            cout << "No depth frames in " << argv[1] << endl;
+            return 1;
+        }
+        cout << frames.size() << " recorded frames from " << argv[1] << endl;
+    } else {
+        frames.resize(SYNTHETIC_FRAMES);
+        for (int i = 0; i < SYNTHETIC_FRAMES; ++i)
+            makeSyntheticDepthFrame(frames[i], i);
+        cout << frames.size() << " synthetic frames" << endl;
+    }
+    int passes = argc > 2 ? std::atoi(argv[2]) : 10;
+    if (passes <= 0) passes = 10;
+
+    depth_codec codec(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+    vector< vector<uint8_t> > encoded(frames.size());
+    vector<uint16_t> decoded(BENCH_WIDTH * BENCH_HEIGHT);
+
+    // Check round trip, and total the encoded size.
+    uint64_t encoded_bytes = 0;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        encoded_bytes += codec.encode(&frames[i].front(), encoded[i]);
+        if (!codec.decode(&encoded[i].front(), encoded[i].size(), &decoded.front()) ||
+            std::memcmp(&decoded.front(), &frames[i].front(), FRAME_BYTES) != 0) {
+            cout << "MISMATCH: frame " << i << " did not round trip" << endl;
+            return 1;
+        }
+    }
+
+    uint64_t start = benchNanos();
+    for (int p = 0; p < passes; ++p)
+        for (size_t i = 0; i < frames.size(); ++i)
+            codec.encode(&frames[i].front(), encoded[i]);
+    uint64_t encode_ns = benchNanos() - start;
+
+    start = benchNanos();
+    for (int p = 0; p < passes; ++p)
+        for (size_t i = 0; i < frames.size(); ++i)
+            codec.decode(&encoded[i].front(), encoded[i].size(), &decoded.front());
+    uint64_t decode_ns = benchNanos() - start;
+
+    double raw_mb = double(FRAME_BYTES) * frames.size() * passes / 1e6;
+    uint64_t coded = frames.size() * passes;
+    cout << fixed << setprecision(2)
+         << "ratio:  " << double(FRAME_BYTES) * frames.size() / encoded_bytes << ":1 ("
+         << encoded_bytes / frames.size() << " bytes/frame)" << endl
+         << "encode: " << raw_mb / (encode_ns / 1e9) << " MB/s, "
+         << encode_ns / coded / 1e6 << " ms/frame" << endl
+         << "decode: " << raw_mb / (decode_ns / 1e9) << " MB/s, "
+         << decode_ns / coded / 1e6 << " ms/frame" << endl;
+    return 0;
+}
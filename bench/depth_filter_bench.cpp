@@ -0,0 +1,146 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// depth_filter_bench.cpp
+// Runs depth_filter over a sequence of depth frames with each kernel,
+// checks the kernels agree, and reports ms/frame alongside how much the
+// filter steadies the depth: pixels that switch between valid and invalid
+// from one frame to the next, and the mean frame to frame change of pixels
+// valid in both. Frames come from a recording made with --record, or are
+// synthetic if none is given.
+//
+// Build (from this directory):
+//   g++ -O2 depth_filter_bench.cpp -o depth_filter_bench
+// Usage:
+//   ./depth_filter_bench [recording.krec] [passes]
+
+#include "bench_util.h"
+#include "../lib/depth_filter.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::setprecision;
+
+#include <vector>
+using std::vector;
+
+const int SYNTHETIC_FRAMES = 60;
+const unsigned PIXELS = BENCH_WIDTH * BENCH_HEIGHT;
+
+// Frame to frame steadiness of a sequence of depth images.
+struct Steadiness {
+    double flicker;  // Fraction of pixels changing validity per frame
+    double change;   // Mean disparity change of pixels valid in both frames
+};
+
+Steadiness measure(const vector< vector<uint16_t> > &frames)
+{
+    uint64_t flips = 0, steady = 0, change = 0;
+    for (size_t f = 1; f < frames.size(); ++f) {
+        const uint16_t *a = &frames[f - 1].front();
+        const uint16_t *b = &frames[f].front();
+        for (unsigned i = 0; i < PIXELS; ++i) {
+            bool va = a[i] < BENCH_INVALID_DEPTH, vb = b[i] < BENCH_INVALID_DEPTH;
+            if (va != vb)
+                ++flips;
+            else if (va) {
+                ++steady;
+                change += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+            }
+        }
+    }
+    Steadiness s;
+    s.flicker = frames.size() > 1 ? double(flips) / (PIXELS * (frames.size() - 1)) : 0;
+    s.change = steady ? double(change) / steady : 0;
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    vector< vector<uint16_t> > frames;
+    if (argc > 1) {
+        if (!loadRecordedDepth(argv[1], frames)) {
+            cout << "No depth frames in " << argv[1] << endl;
+            return 1;
+        }
+        cout << frames.size() << " recorded frames from " << argv[1] << endl;
+    } else {
+        frames.resize(SYNTHETIC_FRAMES);
+        for (int i = 0; i < SYNTHETIC_FRAMES; ++i)
+            makeSyntheticDepthFrame(frames[i], i);
+        cout << frames.size() << " synthetic frames" << endl;
+    }
+    int passes = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (passes <= 0) passes = 5;
+
+    // The scalar kernel is the reference for the others.
+    vector< vector<uint16_t> > reference(frames.size(), vector<uint16_t>(PIXELS));
+    {
+        depth_filter filter(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+        filter.setKernel(depth_filter::SCALAR);
+        for (size_t f = 0; f < frames.size(); ++f)
+            filter.filter(&frames[f].front(), &reference[f].front());
+    }
+
+    Steadiness raw = measure(frames), filtered = measure(reference);
+    cout << fixed << setprecision(4)
+         << "raw:      " << raw.flicker * 100 << "% pixels flicker, "
+         << raw.change << " mean disparity change" << endl
+         << "filtered: " << filtered.flicker * 100 << "% pixels flicker, "
+         << filtered.change << " mean disparity change" << endl;
+
+    vector<uint16_t> out(PIXELS);
+    for (int k = depth_filter::SCALAR; k <= depth_filter::SSE2; ++k) {
+        depth_filter filter(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+        filter.setKernel(depth_filter::Kernel(k));
+        if (filter.getKernel() != k) {
+            cout << depth_filter::kernelName(depth_filter::Kernel(k))
+                 << ": not supported" << endl;
+            continue;
+        }
+
+        for (size_t f = 0; f < frames.size(); ++f) {
+            filter.filter(&frames[f].front(), &out.front());
+            if (std::memcmp(&out.front(), &reference[f].front(), PIXELS * sizeof(uint16_t)) != 0) {
+                cout << "MISMATCH: " << filter.kernelName(filter.getKernel())
+                     << " differs from scalar in frame " << f << endl;
+                return 1;
+            }
+        }
+
+        uint64_t start = benchNanos();
+        for (int p = 0; p < passes; ++p)
+            for (size_t f = 0; f < frames.size(); ++f)
+                filter.filter(&frames[f].front(), &out.front());
+        uint64_t ns = benchNanos() - start;
+
+        cout << setprecision(3) << depth_filter::kernelName(filter.getKernel()) << ": "
+             << ns / 1e6 / (passes * frames.size()) << " ms/frame" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// depth_lut_bench.cpp
+// Replays synthetic 640x480 disparity frames through the depth to vertex
+// conversion done in MyFreenectDevice::DepthCallback, once with the old
+// per pixel tan() evaluation and once with kinect_depth_tables, and reports
+// ns/frame for both.
+//
+// Build (from this directory):
+//   g++ -O2 -msse2 depth_lut_bench.cpp -o depth_lut_bench
+// Usage:
+//   ./depth_lut_bench [frames]
+
+#include "bench_util.h"
+#include "../lib/vec4.h"
+#include "../lib/kinect_depth_tables.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <vector>
+using std::vector;
+
+const int FRAME_VARIANTS = 8;
+
+/* The original kinect_depth_image, kept here as the "before" reference. */
+class reference_depth_image {
+public:
+  reference_depth_image(const uint16_t *d_)
+  : depthi(d_), w(BENCH_WIDTH), h(BENCH_HEIGHT)
+  {
+    pixelFOV=tan(0.5 * (M_PI / 180.0) * 57.8)/(w*0.5);
+  }
+
+  float depth(int x,int y) const {
+    uint16_t disp=depthi[y*w+x];
+    if (disp>= BENCH_INVALID_DEPTH) return 0.0;
+    return 0.1236 * tan(disp / 2842.5 + 1.1863) - 0.037;
+  }
+
+  vec3 dir(int x,int y) const {
+    return vec3((x-w*0.5)*pixelFOV, (h*0.5-y)*pixelFOV, 1);
+  }
+
+  vec3 loc(int x,int y) const {
+    return dir(x,y)*depth(x,y);
+  }
+
+private:
+  const uint16_t *depthi;
+  int w, h;
+  float pixelFOV;
+};
+
+// Old DepthCallback loop.
+void convertReference(const uint16_t *depth, vector<float> &vertices)
+{
+    reference_depth_image img(depth);
+    vertices.clear();
+    for (int yy = 0; yy < BENCH_HEIGHT; yy += 2) {
+        for (int xx = 0; xx < BENCH_WIDTH; xx += 2) {
+            vec3 vertex = img.loc(xx, yy);
+            vertices.push_back(vertex.x);
+            vertices.push_back(vertex.y);
+            vertices.push_back(vertex.z);
+        }
+    }
+}
+
+// Table driven loop.
+void convertTables(const kinect_depth_tables &tables, const uint16_t *depth,
+                   vector<float> &vertices)
+{
+    vertices.resize(BENCH_WIDTH * BENCH_HEIGHT * 3 / 4);
+    float *out = &vertices.front();
+    for (int yy = 0; yy < BENCH_HEIGHT; yy += 2) {
+        const uint16_t *row = depth + yy * BENCH_WIDTH;
+        float ray_y = tables.rayY(yy);
+        for (int xx = 0; xx < BENCH_WIDTH; xx += 2) {
+            float d = tables.meters(row[xx]);
+            *out++ = tables.rayX(xx) * d;
+            *out++ = ray_y * d;
+            *out++ = d;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 300;
+    if (frames <= 0) frames = 300;
+
+    vector< vector<uint16_t> > input(FRAME_VARIANTS);
+    for (int i = 0; i < FRAME_VARIANTS; ++i)
+        makeSyntheticDepthFrame(input[i], i);
+
+    uint64_t start = benchNanos();
+    kinect_depth_tables tables(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+    uint64_t table_build = benchNanos() - start;
+
+    vector<float> before, after;
+
+    // Both loops must produce identical vertices.
+    for (int i = 0; i < FRAME_VARIANTS; ++i) {
+        convertReference(&input[i].front(), before);
+        convertTables(tables, &input[i].front(), after);
+        if (before.size() != after.size() ||
+            std::memcmp(&before.front(), &after.front(), before.size() * sizeof(float)) != 0) {
+            cout << "MISMATCH between reference and table conversion (frame "
+                 << i << ")" << endl;
+            return 1;
+        }
+    }
+
+    start = benchNanos();
+    for (int i = 0; i < frames; ++i)
+        convertReference(&input[i % FRAME_VARIANTS].front(), before);
+    uint64_t reference_ns = benchNanos() - start;
+
+    start = benchNanos();
+    for (int i = 0; i < frames; ++i)
+        convertTables(tables, &input[i % FRAME_VARIANTS].front(), after);
+    uint64_t tables_ns = benchNanos() - start;
+
+    cout << "frames:           " << frames << endl;
+    cout << "table build:      " << table_build << " ns (once)" << endl;
+    cout << "before (tan):     " << reference_ns / frames << " ns/frame" << endl;
+    cout << "after (tables):   " << tables_ns / frames << " ns/frame" << endl;
+    cout << "speedup:          " << double(reference_ns) / tables_ns << "x" << endl;
+
+    return 0;
+}
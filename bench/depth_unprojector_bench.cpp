@@ -0,0 +1,128 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// depth_unprojector_bench.cpp
+// Checks that the SIMD depth_unprojector kernels give bit identical output
+// to the scalar kernel, whole frames or a region at a time, then reports ns/frame of each kernel for the
+// mesh strides the viewer supports, and which kernel the unprojector's own
+// timing picked for each.
+//
+// Build (from this directory):
+//   g++ -O2 -msse2 depth_unprojector_bench.cpp -o depth_unprojector_bench
+// Usage:
+//   ./depth_unprojector_bench [frames]
+
+#include "bench_util.h"
+#include "../lib/depth_unprojector.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+using std::cout;
+using std::endl;
+using std::setw;
+
+#include <vector>
+using std::vector;
+
+const int FRAME_VARIANTS = 8;
+const unsigned STRIDES[] = {1, 2, 4, 8};
+const int STRIDE_COUNT = sizeof(STRIDES) / sizeof(STRIDES[0]);
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 300;
+    if (frames <= 0) frames = 300;
+
+    vector< vector<uint16_t> > input(FRAME_VARIANTS);
+    for (int i = 0; i < FRAME_VARIANTS; ++i)
+        makeSyntheticDepthFrame(input[i], i);
+
+    kinect_depth_tables tables(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+    depth_unprojector unprojector(tables);
+    depth_unprojector::Kernel best = depth_unprojector::bestKernel();
+
+    cout << "widest kernel on this CPU: " << depth_unprojector::kernelName(best) << endl;
+
+    bool ok = true;
+    for (int s = 0; s < STRIDE_COUNT; ++s) {
+        unprojector.setStride(STRIDES[s]);
+        unprojector.useFastestKernel();
+        vector<float> reference(unprojector.vertexCount() * 3);
+        vector<float> out(reference.size());
+
+        cout << "stride " << STRIDES[s] << " (" << unprojector.columns() << "x"
+             << unprojector.rowCount() << " vertices), picked "
+             << depth_unprojector::kernelName(unprojector.getKernel()) << endl;
+
+        for (int k = depth_unprojector::SCALAR; k <= best; ++k) {
+            depth_unprojector::Kernel kernel = depth_unprojector::Kernel(k);
+            unprojector.setKernel(kernel);
+
+            // Compare against scalar output.
+            for (int i = 0; i < FRAME_VARIANTS; ++i) {
+                unprojector.setKernel(depth_unprojector::SCALAR);
+                unprojector.unproject(&input[i].front(), &reference.front());
+                unprojector.setKernel(kernel);
+                unprojector.unproject(&input[i].front(), &out.front());
+                if (std::memcmp(&reference.front(), &out.front(),
+                                out.size() * sizeof(float)) != 0) {
+                    cout << "  MISMATCH: " << depth_unprojector::kernelName(kernel)
+                         << " differs from scalar" << endl;
+                    ok = false;
+                    break;
+                }
+
+                // Converting a region at a time, at odd column offsets, must
+                // give the same vertices.
+                std::fill(out.begin(), out.end(), 0.0f);
+                unsigned cols = unprojector.columns(), rows = unprojector.rowCount();
+                for (unsigned r = 0; r < rows; r += 7) {
+                    for (unsigned c = 0; c < cols; c += 13)
+                        unprojector.unprojectRegion(&input[i].front(), &out.front(),
+                                                    r, std::min(r + 7, rows),
+                                                    c, std::min(c + 13, cols));
+                }
+                if (std::memcmp(&reference.front(), &out.front(),
+                                out.size() * sizeof(float)) != 0) {
+                    cout << "  MISMATCH: " << depth_unprojector::kernelName(kernel)
+                         << " regions differ from scalar" << endl;
+                    ok = false;
+                    break;
+                }
+            }
+
+            uint64_t start = benchNanos();
+            for (int i = 0; i < frames; ++i)
+                unprojector.unproject(&input[i % FRAME_VARIANTS].front(), &out.front());
+            uint64_t ns = benchNanos() - start;
+
+            cout << "  " << setw(7) << depth_unprojector::kernelName(kernel) << ": "
+                 << setw(9) << ns / frames << " ns/frame" << endl;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// hole_fill_bench.cpp
+// Fills the holes of depth frames by push-pull on the CPU
+// (depth_hole_filler.h) and on the GPU (gpu_hole_filler.h with the
+// viewer's shaders), checks the two agree, and reports how many invalid
+// pixels were filled and the time per frame of each. The GPU part renders
+// offscreen through EGL, no display is needed. Frames come from a
+// recording made with --record, or are synthetic if none is given.
+//
+// Build (from this directory):
+//   g++ -O2 hole_fill_bench.cpp -o hole_fill_bench -lEGL -lGL
+// Usage (from this directory, so ../shaders is found):
+//   ./hole_fill_bench [recording.krec] [passes]
+
+#define GL_GLEXT_PROTOTYPES
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "bench_util.h"
+#include "../lib/depth_hole_filler.h"
+#include "../lib/gpu_hole_filler.h"
+#include "../lib/headless_gl.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <string>
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::setprecision;
+
+#include <vector>
+using std::vector;
+
+const int SYNTHETIC_FRAMES = 30;
+const unsigned PIXELS = BENCH_WIDTH * BENCH_HEIGHT;
+
+GLuint compileShaderFile(GLenum type, const char *path)
+{
+    std::ifstream file(path);
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (source.empty()) {
+        cout << "cannot read " << path << endl;
+        std::exit(1);
+    }
+
+    const char *text = source.c_str();
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &text, NULL);
+    glCompileShader(shader);
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        cout << path << ": " << log << endl;
+        std::exit(1);
+    }
+    return shader;
+}
+
+GLuint makeProgram(const char *fragment_path)
+{
+    GLuint program = glCreateProgram();
+    glAttachShader(program, compileShaderFile(GL_VERTEX_SHADER, "../shaders/fullscreen_v.glsl"));
+    glAttachShader(program, compileShaderFile(GL_FRAGMENT_SHADER, fragment_path));
+    glLinkProgram(program);
+    GLint ok = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        cout << fragment_path << " failed to link" << endl;
+        std::exit(1);
+    }
+    return program;
+}
+
+int main(int argc, char **argv)
+{
+    vector< vector<uint16_t> > frames;
+    if (argc > 1) {
+        if (!loadRecordedDepth(argv[1], frames)) {
+            cout << "No depth frames in " << argv[1] << endl;
+            return 1;
+        }
+        cout << frames.size() << " recorded frames from " << argv[1] << endl;
+    } else {
+        frames.resize(SYNTHETIC_FRAMES);
+        for (int i = 0; i < SYNTHETIC_FRAMES; ++i)
+            makeSyntheticDepthFrame(frames[i], i);
+        cout << frames.size() << " synthetic frames" << endl;
+    }
+    int passes = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (passes <= 0) passes = 5;
+
+    // CPU: fill every frame once for the comparison, then time it.
+    depth_hole_filler filler(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+    vector< vector<uint16_t> > filled(frames.size(), vector<uint16_t>(PIXELS));
+    vector< vector<uint8_t> > confidence(frames.size(), vector<uint8_t>(PIXELS));
+    uint64_t holes = 0, left = 0;
+    for (size_t f = 0; f < frames.size(); ++f) {
+        filler.fill(&frames[f].front(), &filled[f].front(), &confidence[f].front());
+        for (unsigned i = 0; i < PIXELS; ++i) {
+            holes += frames[f][i] >= BENCH_INVALID_DEPTH;
+            left += filled[f][i] >= BENCH_INVALID_DEPTH;
+        }
+    }
+    cout << fixed << setprecision(1) << "invalid pixels: " << 100.0 * holes / (PIXELS * frames.size())
+         << "% before, " << 100.0 * left / (PIXELS * frames.size()) << "% after" << endl;
+
+    vector<uint16_t> out(PIXELS);
+    vector<uint8_t> out_confidence(PIXELS);
+    uint64_t start = benchNanos();
+    for (int p = 0; p < passes; ++p)
+        for (size_t f = 0; f < frames.size(); ++f)
+            filler.fill(&frames[f].front(), &out.front(), &out_confidence.front());
+    uint64_t ns = benchNanos() - start;
+    cout << setprecision(3) << "cpu: " << ns / 1e6 / (passes * frames.size()) << " ms/frame" << endl;
+
+    // GPU.
+    headless_gl context;
+    if (!context.create()) {
+        cout << "no headless OpenGL context, skipping the GPU" << endl;
+        return 0;
+    }
+
+    gpu_hole_filler gpu;
+    gpu.create(makeProgram("../shaders/hole_pull_f.glsl"),
+               makeProgram("../shaders/hole_push_f.glsl"), BENCH_INVALID_DEPTH);
+    gpu.resize(BENCH_WIDTH, BENCH_HEIGHT);
+
+    GLuint depth_texture;
+    glGenTextures(1, &depth_texture);
+    glBindTexture(GL_TEXTURE_2D, depth_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R16UI, BENCH_WIDTH, BENCH_HEIGHT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+
+    // Compare with the CPU: disparities within 1 and confidence within
+    // 1/255, allowing for float rounding.
+    vector<float> readback(PIXELS * 2);
+    for (size_t f = 0; f < frames.size(); ++f) {
+        glBindTexture(GL_TEXTURE_2D, depth_texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, BENCH_WIDTH, BENCH_HEIGHT,
+                        GL_RED_INTEGER, GL_UNSIGNED_SHORT, &frames[f].front());
+        gpu.fill(depth_texture);
+        glBindTexture(GL_TEXTURE_2D, gpu.filledTexture());
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RG, GL_FLOAT, &readback.front());
+
+        for (unsigned i = 0; i < PIXELS; ++i) {
+            float conf = readback[2 * i + 1];
+            int disp = conf > 0.0f ? int(readback[2 * i] + 0.5f) : BENCH_INVALID_DEPTH;
+            int expected = filled[f][i];
+            int conf_diff = int(conf * 255.0f + 0.5f) - confidence[f][i];
+            if (std::abs(disp - expected) > 1 || std::abs(conf_diff) > 1) {
+                cout << "MISMATCH: frame " << f << " pixel " << i % BENCH_WIDTH << ","
+                     << i / BENCH_WIDTH << ": gpu " << disp << " (" << conf
+                     << "), cpu " << expected << " (" << confidence[f][i] / 255.0 << ")" << endl;
+                return 1;
+            }
+        }
+    }
+
+    glFinish();
+    start = benchNanos();
+    for (int p = 0; p < passes; ++p) {
+        for (size_t f = 0; f < frames.size(); ++f) {
+            glBindTexture(GL_TEXTURE_2D, depth_texture);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, BENCH_WIDTH, BENCH_HEIGHT,
+                            GL_RED_INTEGER, GL_UNSIGNED_SHORT, &frames[f].front());
+            gpu.fill(depth_texture);
+        }
+    }
+    glFinish();
+    ns = benchNanos() - start;
+    cout << "gpu: " << ns / 1e6 / (passes * frames.size())
+         << " ms/frame including upload, "
+         << reinterpret_cast<const char *>(glGetString(GL_RENDERER)) << endl;
+
+    gpu.destroy();
+    glDeleteTextures(1, &depth_texture);
+    context.destroy();
+    return 0;
+}
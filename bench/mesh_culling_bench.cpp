@@ -0,0 +1,377 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// mesh_culling_bench.cpp
+// Compares three ways of dropping Kinect mesh triangles that span a depth
+// discontinuity: the geometry shader the viewer has always used, drawing
+// compacted triangle indices, and NaN vertices (see mesh_culling.h).
+//
+// Checks that the geometry shader and the compacted indices draw the same
+// number of triangles, and that every triangle the compacted indices drop
+// has a NaN vertex. Then for each mesh stride reports the triangles each way draws, the
+// depth thread's time to compact or mark a frame, and the time to upload
+// and draw a frame on the GPU, with the viewer's shaders. The GPU part
+// renders offscreen through EGL, no display is needed.
+//
+// Build (from this directory):
+//   g++ -O2 -msse2 mesh_culling_bench.cpp -o mesh_culling_bench -lEGL -lGL
+// Usage (from this directory, so ../shaders is found):
+//   ./mesh_culling_bench [frames]
+
+#define GL_GLEXT_PROTOTYPES
+
+#include "bench_util.h"
+#include "../lib/depth_unprojector.h"
+#include "../lib/mesh_culling.h"
+#include "../lib/headless_gl.h"
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <math.h>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <string>
+using std::cout;
+using std::endl;
+using std::setw;
+using std::fixed;
+using std::setprecision;
+
+#include <vector>
+using std::vector;
+
+const int FRAME_VARIANTS = 8;
+const unsigned STRIDES[] = {1, 2, 4, 8};
+const int STRIDE_COUNT = sizeof(STRIDES) / sizeof(STRIDES[0]);
+const float MAX_EDGE = .1;
+const unsigned RESTART_INDEX = 0xFFFFFFFF;
+const int TARGET_W = 1182;  // DK2 eye texture
+const int TARGET_H = 1461;
+
+enum Approach {GEOMETRY_SHADER, COMPACT_INDICES, NAN_VERTICES, APPROACHES};
+const char *APPROACH_NAMES[APPROACHES] = {"geometry shader", "compact indices", "nan vertices"};
+
+GLuint compileShaderFile(GLenum type, const char *path)
+{
+    std::ifstream file(path);
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (source.empty()) {
+        cout << "cannot read " << path << endl;
+        std::exit(1);
+    }
+
+    const char *text = source.c_str();
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &text, NULL);
+    glCompileShader(shader);
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        cout << path << ": " << log << endl;
+        std::exit(1);
+    }
+    return shader;
+}
+
+// The viewer's Kinect mesh program, with or without its culling geometry
+// shader. Draws one eye, unfilled, textured from unit 0.
+GLuint makeProgram(bool geometry_shader)
+{
+    GLuint program = glCreateProgram();
+    glAttachShader(program, compileShaderFile(GL_VERTEX_SHADER, "../shaders/invalids_v.glsl"));
+    if (geometry_shader)
+        glAttachShader(program, compileShaderFile(GL_GEOMETRY_SHADER, "../shaders/normals_g.glsl"));
+    glAttachShader(program, compileShaderFile(GL_FRAGMENT_SHADER, "../shaders/invalids_f.glsl"));
+    glLinkProgram(program);
+    GLint ok = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        cout << "program failed to link: " << log << endl;
+        std::exit(1);
+    }
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "side_by_side"), 0);
+    glUniform1i(glGetUniformLocation(program, "fill_holes"), 0);
+    glUniform1i(glGetUniformLocation(program, "texture"), 0);
+    glUseProgram(0);
+    return program;
+}
+
+// Triangle strips over each pair of vertex rows, as the viewer draws them.
+void makeStripIndices(unsigned cols, unsigned rows, vector<unsigned> &indices)
+{
+    indices.clear();
+    for (unsigned y = 0; y + 1 < rows; ++y) {
+        for (unsigned x = 0; x < cols; ++x) {
+            indices.push_back(y * cols + x);
+            indices.push_back((y + 1) * cols + x);
+        }
+        indices.push_back(RESTART_INDEX);
+    }
+}
+
+// Perspective looking down +z from the Kinect, column major.
+void makeProjection(float *m)
+{
+    const float f = 1 / tan(30 * M_PI / 180), near = .1, far = 10;
+    for (int i = 0; i < 16; ++i) m[i] = 0;
+    m[0] = f * TARGET_H / TARGET_W;
+    m[5] = f;
+    m[10] = (far + near) / (far - near);
+    m[11] = 1;
+    m[14] = -2 * far * near / (far - near);
+}
+
+// True if any of the three vertices is NaN.
+bool hasNaN(const float *xyz, const unsigned *triangle)
+{
+    for (int i = 0; i < 3; ++i)
+        if (xyz[3 * triangle[i]] != xyz[3 * triangle[i]])
+            return true;
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 100;
+    if (frames <= 0) frames = 100;
+
+    vector< vector<uint16_t> > input(FRAME_VARIANTS);
+    for (int i = 0; i < FRAME_VARIANTS; ++i)
+        makeSyntheticDepthFrame(input[i], i);
+
+    headless_gl context;
+    if (!context.create()) {
+        cout << "no headless OpenGL context" << endl;
+        return 1;
+    }
+    cout << "GL renderer: " << glGetString(GL_RENDERER) << endl;
+
+    // Offscreen target the size of an eye.
+    GLuint framebuffer, renderbuffers[2];
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, TARGET_W, TARGET_H);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, TARGET_W, TARGET_H);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    glViewport(0, 0, TARGET_W, TARGET_H);
+    glEnable(GL_DEPTH_TEST);
+
+    GLuint programs[APPROACHES];
+    programs[GEOMETRY_SHADER] = makeProgram(true);
+    programs[COMPACT_INDICES] = programs[NAN_VERTICES] = makeProgram(false);
+    float projection[16];
+    makeProjection(projection);
+
+    GLuint query;
+    glGenQueries(1, &query);
+
+    GLuint vao, vertex_buffer, uv_buffer, strip_buffer, triangle_buffer;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glGenBuffers(1, &vertex_buffer);
+    glGenBuffers(1, &uv_buffer);
+    glGenBuffers(1, &strip_buffer);
+    glGenBuffers(1, &triangle_buffer);
+
+    // A video frame for the fragment shader to sample.
+    vector<uint8_t> rgb(BENCH_WIDTH * BENCH_HEIGHT * 3);
+    for (unsigned i = 0; i < rgb.size(); ++i)
+        rgb[i] = uint8_t(i * 7);
+    GLuint video_texture;
+    glGenTextures(1, &video_texture);
+    glBindTexture(GL_TEXTURE_2D, video_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, BENCH_WIDTH, BENCH_HEIGHT, 0, GL_RGB,
+                 GL_UNSIGNED_BYTE, &rgb.front());
+
+    kinect_depth_tables tables(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+    depth_unprojector unprojector(tables);
+
+    bool ok = true;
+    for (int s = 0; s < STRIDE_COUNT; ++s) {
+        unprojector.setStride(STRIDES[s]);
+        unsigned cols = unprojector.columns(), rows = unprojector.rowCount();
+        unsigned all_triangles = 2 * (cols - 1) * (rows - 1);
+
+        // Unprojected frames, and copies with culled vertices marked.
+        vector< vector<float> > vertices(FRAME_VARIANTS), marked(FRAME_VARIANTS);
+        for (int i = 0; i < FRAME_VARIANTS; ++i) {
+            vertices[i].resize(unprojector.vertexCount() * 3);
+            unprojector.unproject(&input[i].front(), &vertices[i].front());
+            marked[i] = vertices[i];
+            markCulledMeshVertices(&marked[i].front(), cols, rows, MAX_EDGE);
+        }
+
+        vector<uint32_t> triangles(meshTriangleIndexCapacity(cols, rows));
+        vector<unsigned> strips;
+        makeStripIndices(cols, rows, strips);
+
+        // Every vertex samples the video at its grid position.
+        vector<float> uvs;
+        for (unsigned y = 0; y < rows; ++y) {
+            for (unsigned x = 0; x < cols; ++x) {
+                uvs.push_back(float(x) / (cols - 1));
+                uvs.push_back(float(y) / (rows - 1));
+            }
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, uv_buffer);
+        glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(float), &uvs.front(), GL_STATIC_DRAW);
+        glTexCoordPointer(2, GL_FLOAT, 0, 0);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+        // Triangles drawn, and every dropped triangle has a NaN vertex.
+        unsigned compact_count = compactMeshTriangles(&vertices[0].front(), cols, rows,
+                                                      MAX_EDGE, &triangles.front());
+        vector<bool> kept(all_triangles, false);
+        for (unsigned i = 0; i < compact_count; i += 3) {
+            // Both triangles of a square have its lower left vertex second.
+            unsigned x = triangles[i + 1] % cols, y = triangles[i + 1] / cols - 1;
+            bool second = triangles[i] != y * cols + x;
+            kept[2 * (y * (cols - 1) + x) + second] = true;
+        }
+        unsigned nan_kept = 0;
+        bool nan_ok = true;
+        for (unsigned y = 0; y + 1 < rows; ++y) {
+            for (unsigned x = 0; x + 1 < cols; ++x) {
+                unsigned a = y * cols + x, b = a + cols;
+                unsigned first[3] = {a, b, a + 1}, second[3] = {a + 1, b, b + 1};
+                unsigned t = 2 * (y * (cols - 1) + x);
+                bool first_nan = hasNaN(&marked[0].front(), first);
+                bool second_nan = hasNaN(&marked[0].front(), second);
+                nan_kept += !first_nan + !second_nan;
+                if ((!kept[t] && !first_nan) || (!kept[t + 1] && !second_nan))
+                    nan_ok = false;
+            }
+        }
+
+        cout << "stride " << STRIDES[s] << " (" << all_triangles << " triangles)" << endl;
+        if (!nan_ok) {
+            cout << "  MISMATCH: a triangle compaction drops has no NaN vertex" << endl;
+            ok = false;
+        }
+        cout << "  triangles drawn: geometry shader and compact indices "
+             << compact_count / 3 << ", nan vertices " << nan_kept << endl;
+
+        // Depth thread cost.
+        vector<float> scratch(vertices[0].size());
+        uint64_t compact_ns = 0, mark_ns = 0;
+        for (int i = 0; i < frames; ++i) {
+            const vector<float> &frame = vertices[i % FRAME_VARIANTS];
+            uint64_t start = benchNanos();
+            compactMeshTriangles(&frame.front(), cols, rows, MAX_EDGE, &triangles.front());
+            compact_ns += benchNanos() - start;
+
+            scratch = frame;
+            start = benchNanos();
+            markCulledMeshVertices(&scratch.front(), cols, rows, MAX_EDGE);
+            mark_ns += benchNanos() - start;
+        }
+        cout << fixed << setprecision(3)
+             << "  cpu ms/frame: compact indices " << compact_ns / 1e6 / frames
+             << ", nan vertices " << mark_ns / 1e6 / frames << endl;
+
+        // Upload and draw one frame at a time, waiting for each.
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, strip_buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, strips.size() * sizeof(unsigned),
+                     &strips.front(), GL_STATIC_DRAW);
+        cout << "  gpu ms/frame:";
+        for (int a = 0; a < APPROACHES; ++a) {
+            glUseProgram(programs[a]);
+            glUniformMatrix4fv(glGetUniformLocation(programs[a], "eye_mvp"), 1, GL_FALSE, projection);
+
+            uint64_t draw_ns = 0;
+            for (int i = -1; i < frames; ++i) {  // Frame -1 warms up.
+                int v = (i + FRAME_VARIANTS) % FRAME_VARIANTS;
+                const vector<float> &frame = a == NAN_VERTICES ? marked[v] : vertices[v];
+                unsigned index_count = 0;
+                if (a == COMPACT_INDICES)
+                    index_count = compactMeshTriangles(&vertices[v].front(), cols, rows,
+                                                       MAX_EDGE, &triangles.front());
+
+                // Count what the geometry shader emits on the warm up frame.
+                bool count_primitives = a == GEOMETRY_SHADER && i == -1;
+                if (count_primitives)
+                    glBeginQuery(GL_PRIMITIVES_GENERATED, query);
+
+                uint64_t start = benchNanos();
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+                glBufferData(GL_ARRAY_BUFFER, frame.size() * sizeof(float), &frame.front(), GL_STREAM_DRAW);
+                glVertexPointer(3, GL_FLOAT, 0, 0);
+                glEnableClientState(GL_VERTEX_ARRAY);
+
+                if (a == COMPACT_INDICES) {
+                    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangle_buffer);
+                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(uint32_t),
+                                 &triangles.front(), GL_STREAM_DRAW);
+                    glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, 0);
+                } else {
+                    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, strip_buffer);
+                    glEnable(GL_PRIMITIVE_RESTART);
+                    glPrimitiveRestartIndex(RESTART_INDEX);
+                    glDrawElements(GL_TRIANGLE_STRIP, strips.size(), GL_UNSIGNED_INT, 0);
+                    glDisable(GL_PRIMITIVE_RESTART);
+                }
+                glFinish();
+                if (i >= 0)
+                    draw_ns += benchNanos() - start;
+
+                if (count_primitives) {
+                    glEndQuery(GL_PRIMITIVES_GENERATED);
+                    GLuint emitted = 0;
+                    glGetQueryObjectuiv(query, GL_QUERY_RESULT, &emitted);
+                    unsigned expected = compactMeshTriangles(&vertices[v].front(), cols, rows,
+                                                             MAX_EDGE, &triangles.front()) / 3;
+                    if (emitted != expected) {
+                        cout << "  MISMATCH: geometry shader drew " << emitted
+                             << " triangles, compact indices " << expected << endl;
+                        ok = false;
+                    }
+                }
+            }
+            cout << " " << APPROACH_NAMES[a] << " " << draw_ns / 1e6 / frames
+                 << (a + 1 < APPROACHES ? "," : "\n");
+        }
+    }
+
+    if (GLenum err = glGetError()) {
+        cout << "GL error " << err << endl;
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
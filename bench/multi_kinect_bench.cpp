@@ -0,0 +1,181 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// multi_kinect_bench.cpp
+// Measures how depth conversion scales with the number of Kinects. Each
+// simulated Kinect has a capture thread feeding depth frames, as fast as
+// they are taken, to its own depth_worker pinned to a core, the way the
+// viewer replays recordings with --replay-fast. Every worker filters its
+// frames and converts them to stride 2 vertices with compacted triangles.
+// Reports frames converted per second for 1 to MAX_KINECTS Kinects, and
+// how close that is to the single Kinect rate times the Kinect count.
+// Frames come from a recording made with --record, or are synthetic if
+// none is given.
+//
+// Build (from this directory):
+//   g++ -O2 -msse2 -I../lib/LibOVR/Src multi_kinect_bench.cpp -o multi_kinect_bench -lpthread
+// Usage:
+//   ./multi_kinect_bench [recording.krec] [frames per Kinect]
+
+#include "bench_util.h"
+#include "../lib/depth_worker.h"
+#include "../lib/depth_filter.h"
+#include "../lib/depth_unprojector.h"
+#include "../lib/kinect_depth_tables.h"
+#include "../lib/mesh_culling.h"
+
+#include <unistd.h>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::setprecision;
+
+#include <vector>
+using std::vector;
+
+const int MAX_KINECTS = 4;
+const int SYNTHETIC_FRAMES = 30;
+const float MAX_EDGE = .1f;
+
+// What a Kinect's worker does with every frame.
+class bench_converter : public depth_worker::converter {
+public:
+    explicit bench_converter(const kinect_depth_tables &tables)
+    : filter(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH),
+      unprojector(tables, 2),
+      filtered(BENCH_WIDTH * BENCH_HEIGHT),
+      vertices(BENCH_WIDTH * BENCH_HEIGHT * 3),
+      indices(meshTriangleIndexCapacity(BENCH_WIDTH, BENCH_HEIGHT))
+    {
+        converted = 0;
+    }
+
+    void convertDepth(const uint16_t *depth, uint64_t) {
+        filter.filter(depth, &filtered.front());
+        unprojector.unproject(&filtered.front(), &vertices.front());
+        compactMeshTriangles(&vertices.front(), unprojector.columns(),
+                             unprojector.rowCount(), MAX_EDGE, &indices.front());
+        converted += 1;
+    }
+
+    OVR::AtomicInt<unsigned> converted;
+
+private:
+    depth_filter filter;
+    depth_unprojector unprojector;
+    vector<uint16_t> filtered;
+    vector<float> vertices;
+    vector<uint32_t> indices;
+};
+
+// A simulated Kinect's capture thread.
+struct Capture {
+    depth_worker *worker;
+    const vector< vector<uint16_t> > *frames;
+    int count;  // Frames to submit
+    pthread_t thread;
+};
+
+void *captureThread(void *arg)
+{
+    Capture *capture = static_cast<Capture*>(arg);
+    const vector< vector<uint16_t> > &frames = *capture->frames;
+    for (int i = 0; i < capture->count; ++i)
+        capture->worker->submit(&frames[i % frames.size()].front(), benchNanos());
+    return NULL;
+}
+
+// Converts frames_each frames on each of kinects workers, and returns the
+// frames converted per second over all of them.
+double run(int kinects, int frames_each, const vector< vector<uint16_t> > &frames,
+           const kinect_depth_tables &tables)
+{
+    int cores = depth_worker::coreCount();
+    vector<bench_converter*> converters;
+    vector<depth_worker*> workers;
+    vector<Capture> captures(kinects);
+    for (int i = 0; i < kinects; ++i) {
+        converters.push_back(new bench_converter(tables));
+        workers.push_back(new depth_worker(BENCH_WIDTH * BENCH_HEIGHT));
+        workers[i]->start(converters[i], (i + 1) % cores, NULL, true);
+    }
+
+    uint64_t start = benchNanos();
+    for (int i = 0; i < kinects; ++i) {
+        captures[i].worker = workers[i];
+        captures[i].frames = &frames;
+        captures[i].count = frames_each;
+        pthread_create(&captures[i].thread, NULL, &captureThread, &captures[i]);
+    }
+    for (int i = 0; i < kinects; ++i) {
+        pthread_join(captures[i].thread, NULL);
+        while (converters[i]->converted < unsigned(frames_each))
+            usleep(100);
+    }
+    uint64_t ns = benchNanos() - start;
+
+    for (int i = 0; i < kinects; ++i) {
+        workers[i]->stop();
+        delete workers[i];
+        delete converters[i];
+    }
+    return kinects * frames_each / (ns / 1e9);
+}
+
+int main(int argc, char **argv)
+{
+    vector< vector<uint16_t> > frames;
+    if (argc > 1) {
+        if (!loadRecordedDepth(argv[1], frames)) {
+            cout << "No depth frames in " << argv[1] << endl;
+            return 1;
+        }
+        cout << frames.size() << " recorded frames from " << argv[1] << endl;
+    } else {
+        frames.resize(SYNTHETIC_FRAMES);
+        for (int i = 0; i < SYNTHETIC_FRAMES; ++i)
+            makeSyntheticDepthFrame(frames[i], i);
+        cout << frames.size() << " synthetic frames" << endl;
+    }
+    int frames_each = argc > 2 ? std::atoi(argv[2]) : 300;
+    if (frames_each <= 0) frames_each = 300;
+
+    int cores = depth_worker::coreCount();
+    cout << cores << " cores" << endl;
+
+    kinect_depth_tables tables(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+    double single = 0;
+    for (int kinects = 1; kinects <= MAX_KINECTS; ++kinects) {
+        double fps = run(kinects, frames_each, frames, tables);
+        if (kinects == 1)
+            single = fps;
+        cout << fixed << setprecision(1) << kinects << " Kinect" << (kinects > 1 ? "s: " : ":  ")
+             << fps << " frames/s, " << setprecision(0)
+             << 100 * fps / (kinects * single) << "% of linear"
+             << (kinects + 1 > cores ? " (more workers than free cores)" : "") << endl;
+    }
+    return 0;
+}
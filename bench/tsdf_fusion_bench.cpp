@@ -0,0 +1,122 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// tsdf_fusion_bench.cpp
+// Fuses a sequence of depth frames into a tsdf_volume, on 1 thread up to
+// every core, and reports ms/frame for integration and marching cubes
+// against the Kinect's 30 Hz frame budget, with the size of the result.
+// Frames come from a recording made with --record, or are synthetic if
+// none is given.
+//
+// Build (from this directory):
+//   g++ -O2 -I../lib/LibOVR/Src tsdf_fusion_bench.cpp -o tsdf_fusion_bench -lpthread
+// Usage:
+//   ./tsdf_fusion_bench [recording.krec] [voxel size in meters]
+
+#include "bench_util.h"
+#include "../lib/tsdf_volume.h"
+#include "../lib/depth_filter.h"
+#include "../lib/depth_worker.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::setprecision;
+
+#include <vector>
+using std::vector;
+
+const int SYNTHETIC_FRAMES = 60;
+const double BUDGET_MS = 1000.0 / 30;
+
+int main(int argc, char **argv)
+{
+    vector< vector<uint16_t> > frames;
+    if (argc > 1 && argv[1][0]) {
+        if (!loadRecordedDepth(argv[1], frames)) {
+            cout << "No depth frames in " << argv[1] << endl;
+            return 1;
+        }
+        cout << frames.size() << " recorded frames from " << argv[1] << endl;
+    } else {
+        frames.resize(SYNTHETIC_FRAMES);
+        for (int i = 0; i < SYNTHETIC_FRAMES; ++i)
+            makeSyntheticDepthFrame(frames[i], i);
+        cout << frames.size() << " synthetic frames" << endl;
+    }
+    float voxel_size = argc > 2 ? float(std::atof(argv[2])) : .02f;
+    if (voxel_size <= 0) voxel_size = .02f;
+
+    // The viewer fuses filtered depth.
+    depth_filter filter(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+    for (size_t f = 0; f < frames.size(); ++f) {
+        vector<uint16_t> filtered(frames[f].size());
+        filter.filter(&frames[f].front(), &filtered.front());
+        frames[f].swap(filtered);
+    }
+
+    kinect_depth_tables tables(BENCH_WIDTH, BENCH_HEIGHT, BENCH_INVALID_DEPTH);
+    int cores = depth_worker::coreCount();
+    cout << cores << " cores, " << voxel_size * 100 << " cm voxels, budget "
+         << fixed << setprecision(1) << BUDGET_MS << " ms/frame" << endl;
+
+    // Powers of two, then every core.
+    vector<int> thread_counts;
+    for (int threads = 1; threads < cores; threads *= 2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(cores);
+
+    for (size_t t = 0; t < thread_counts.size(); ++t) {
+        int threads = thread_counts[t];
+        parallel_for pool(threads - 1);
+        tsdf_volume volume(tables, BENCH_INVALID_DEPTH, voxel_size);
+        uint64_t integrate_ns = 0, extract_ns = 0;
+        unsigned remeshed = 0;
+        for (size_t f = 0; f < frames.size(); ++f) {
+            uint64_t start = benchNanos();
+            volume.integrate(&frames[f].front(), &pool);
+            uint64_t integrated = benchNanos();
+            volume.extract(&pool);
+            extract_ns += benchNanos() - integrated;
+            integrate_ns += integrated - start;
+            remeshed += volume.remeshedCount();
+        }
+
+        vector<float> mesh;
+        volume.appendMesh(mesh);
+        double integrate_ms = integrate_ns / 1e6 / frames.size();
+        double extract_ms = extract_ns / 1e6 / frames.size();
+        cout << setprecision(2) << threads << " thread" << (threads > 1 ? "s: " : ":  ")
+             << integrate_ms << " ms integrate + " << extract_ms << " ms marching cubes = "
+             << integrate_ms + extract_ms << " ms/frame"
+             << (integrate_ms + extract_ms > BUDGET_MS ? " (OVER BUDGET)" : "")
+             << ", " << volume.blockCount() << " blocks"
+             << (volume.isFull() ? " (full)" : "")
+             << ", " << remeshed / frames.size() << " remeshed/frame, "
+             << mesh.size() / tsdf_volume::FLOATS_PER_VERTEX / 3 << " triangles" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#!/bin/sh
+# viewer_bench_test.sh
+# Runs the viewer's own --bench mode headless, with synthetic Kinects, in
+# each of its main configurations. Checks every run exits cleanly, renders
+# all its frames, and uploaded Kinect geometry while it was timed. Then
+# checks bad --bench arguments are refused.
+# Needs an EGL capable OpenGL driver, no display or Kinect.
+#
+# Usage (from this directory, with the viewer built in the repository root):
+#   ./viewer_bench_test.sh [path/to/vr_oculus_kinect]
+
+viewer=${1:-../vr_oculus_kinect}
+case $viewer in
+    /*) ;;
+    *) viewer=$(pwd)/$viewer ;;
+esac
+
+# The viewer loads shaders/ relative to the repository root.
+cd "$(dirname "$0")/.." || exit 1
+
+frames=10
+report=$(mktemp)
+failed=0
+
+# Value of a number field in the report.
+field() {
+    sed -n "s/.*\"$1\": \([0-9.]*\).*/\1/p" "$report" | head -n 1
+}
+
+# run NAME UPLOAD ARGS...: benchmark with ARGS, UPLOAD is the
+# bytes_uploaded field that must not be 0.
+run() {
+    name=$1
+    upload=$2
+    shift 2
+    if ! "$viewer" --bench $frames --bench-report "$report" "$@" > /dev/null 2>&1; then
+        echo "FAIL $name: exited with an error"
+        failed=1
+        return
+    fi
+    if [ "$(field frames)" != $frames ] || [ "$(field rendered_frames)" != $frames ]; then
+        echo "FAIL $name: rendered $(field rendered_frames) of $frames frames"
+        failed=1
+        return
+    fi
+    bytes=$(sed -n "s/.*\"$upload\": \([0-9]*\).*/\1/p" "$report")
+    if [ -z "$bytes" ] || [ "$bytes" -eq 0 ]; then
+        echo "FAIL $name: no $upload bytes uploaded while timed"
+        failed=1
+        return
+    fi
+    echo "ok   $name: $(field fps) fps"
+}
+
+# refuse NAME ARGS...: the viewer must reject ARGS.
+refuse() {
+    name=$1
+    shift
+    if "$viewer" "$@" > /dev/null 2>&1; then
+        echo "FAIL $name: accepted"
+        failed=1
+    else
+        echo "ok   $name: refused"
+    fi
+}
+
+run "mesh"                 vertices
+run "compacted indices"    vertices --cull indices
+run "nan vertices"         vertices --cull nan
+run "points"               vertices --points
+run "gpu unprojection"     depth    --gpu-unproject --fill-holes gpu
+run "fusion"               vertices --fuse
+run "two kinects"          vertices --kinects 2 --threads 2
+run "single pass"          vertices --single-pass
+
+refuse "negative frames"   --bench -1
+refuse "frames not number" --bench foo
+refuse "trailing junk"     --bench 10x
+refuse "stride not number" --stride two --bench 1
+
+rm -f "$report"
+exit $failed
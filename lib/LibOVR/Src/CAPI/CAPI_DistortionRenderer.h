@@ -90,6 +90,10 @@ public:
         RegisteredPostDistortionCallback = postDistortionCallback;
     }
 
+    // GPU time of a recent distortion pass in milliseconds, or -1 if the
+    // implementation doesn't measure it.
+    virtual float GetGpuDistortionMillis() const { return -1.0f; }
+
 	// Stores the current graphics pipeline state so it can be restored later.
 	void SaveGraphicsState() { if (GfxState && !(RState.DistortionCaps & ovrDistortionCap_NoRestore)) GfxState->Save(); }
 
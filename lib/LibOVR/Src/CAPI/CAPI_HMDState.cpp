@@ -481,6 +481,10 @@ float HMDState::getFloatValue(const char* propertyName, float defaultVal)
     {
         return OurHMDInfo.Shutter.PixelPersistence;
     }
+    else if (OVR_strcmp(propertyName, OVR_KEY_GPU_DISTORTION_MS) == 0)
+    {
+        return pRenderer ? pRenderer->GetGpuDistortionMillis() : defaultVal;
+    }
     else if (NetSessionCommon::IsServiceProperty(NetSessionCommon::EGetNumberValue, propertyName))
     {
        return (float)NetClient::GetInstance()->GetNumberValue(GetNetId(), propertyName, defaultVal);
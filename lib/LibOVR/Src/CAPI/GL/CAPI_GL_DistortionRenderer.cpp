@@ -115,10 +115,15 @@ DistortionRenderer::DistortionRenderer(ovrHmd hmd, FrameTimeManager& timeManager
     , RotateCCW90(false)
 	, LatencyVAO(0)
     , OverdriveFbo(0)
+    , DistortionTimerIndex(0)
+    , GpuDistortionMillis(-1.0f)
 {
 	DistortionMeshVAOs[0] = 0;
 	DistortionMeshVAOs[1] = 0;
 
+    memset(DistortionTimerQueries, 0, sizeof(DistortionTimerQueries));
+    memset(DistortionTimerPending, 0, sizeof(DistortionTimerPending));
+
     // Initialize render params.
     memset(&RParams, 0, sizeof(RParams));
 }
@@ -294,9 +299,49 @@ void DistortionRenderer::SubmitEye(int eyeId, const ovrTexture* eyeTexture)
 	}
 }
 
+void DistortionRenderer::beginDistortionTimer()
+{
+    if (!GLE_ARB_timer_query)
+        return;
+
+    // Queries belong to the distortion context, create them while it is bound.
+    if (DistortionTimerQueries[0][0] == 0)
+        glGenQueries(NumDistortionTimers * 2, &DistortionTimerQueries[0][0]);
+
+    // Collect the result this slot got NumDistortionTimers frames ago.
+    GLuint* queries = DistortionTimerQueries[DistortionTimerIndex];
+    if (DistortionTimerPending[DistortionTimerIndex])
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return; // GPU is far behind, skip timing this frame rather than wait.
+
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &end);
+        GpuDistortionMillis = (float)((end - begin) / 1e6);
+        DistortionTimerPending[DistortionTimerIndex] = false;
+    }
+
+    glQueryCounter(queries[0], GL_TIMESTAMP);
+}
+
+void DistortionRenderer::endDistortionTimer()
+{
+    if (!GLE_ARB_timer_query || DistortionTimerPending[DistortionTimerIndex])
+        return; // No timer was started this frame.
+
+    glQueryCounter(DistortionTimerQueries[DistortionTimerIndex][1], GL_TIMESTAMP);
+    DistortionTimerPending[DistortionTimerIndex] = true;
+    DistortionTimerIndex = (DistortionTimerIndex + 1) % NumDistortionTimers;
+}
+
 void DistortionRenderer::renderEndFrame()
 {
+    beginDistortionTimer();
     renderDistortion(pEyeTextures[0], pEyeTextures[1]);
+    endDistortionTimer();
 
     // TODO: Add rendering context to callback.
     if(RegisteredPostDistortionCallback)
@@ -1002,6 +1047,13 @@ void DistortionRenderer::destroy()
         glDeleteFramebuffers(1, &OverdriveFbo);
     }
 
+    if(DistortionTimerQueries[0][0] != 0)
+    {
+        glDeleteQueries(NumDistortionTimers * 2, &DistortionTimerQueries[0][0]);
+        memset(DistortionTimerQueries, 0, sizeof(DistortionTimerQueries));
+        memset(DistortionTimerPending, 0, sizeof(DistortionTimerPending));
+    }
+
     currContext.Bind();
     distortionContext.Destroy();
     // Who is responsible for destroying the app's context?
@@ -61,6 +61,8 @@ public:
 
     virtual void EndFrame(bool swapBuffers);
 
+    virtual float GetGpuDistortionMillis() const { return GpuDistortionMillis; }
+
     void         WaitUntilGpuIdle();
 
 	// Similar to ovr_WaitTillTime but it also flushes GPU.
@@ -111,6 +113,17 @@ protected:
 	
     void renderEndFrame();
 
+    // GPU timing of the distortion pass. Timestamps are read back
+    // NumDistortionTimers frames later, so reading never stalls.
+    enum { NumDistortionTimers = 4 };
+    void beginDistortionTimer();
+    void endDistortionTimer();
+
+    GLuint              DistortionTimerQueries[NumDistortionTimers][2]; // begin, end
+    bool                DistortionTimerPending[NumDistortionTimers];
+    int                 DistortionTimerIndex;
+    float               GpuDistortionMillis;
+
     Ptr<Texture>        pEyeTextures[2];
 
 	Ptr<Buffer>         DistortionMeshVBs[2];    // one per-eye
@@ -38,6 +38,7 @@ limitations under the License.
 #define OVR_KEY_MAX_EYE_TO_PLATE_DISTANCE   "MaxEyeToPlateDist" // float[2]
 #define OVR_KEY_EYE_CUP                     "EyeCup"            // char[16]
 #define OVR_KEY_CUSTOM_EYE_RENDER           "CustomEyeRender"   // bool
+#define OVR_KEY_GPU_DISTORTION_MS           "GpuDistortionMs"   // float, read only
 #define OVR_KEY_CAMERA_POSITION				"CenteredFromWorld" // double[7]
 
 // Default measurements empirically determined at Oculus to make us happy
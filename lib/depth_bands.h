@@ -0,0 +1,244 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// depth_bands.h
+// Splits the per-frame CPU stages of the Kinect pipeline into bands of
+// rows, and runs the bands on a parallel_for.
+// There is no associated source file.
+// Requires LibOVR's Kernel/OVR_Atomic.h and pthreads, for parallel_for.
+//
+// Every stage gives the same output as its single threaded version.
+// Each band is BAND_ROWS rows of the image or grid, small enough that the
+// pool can balance rows with more work, like edges, between threads, and
+// large enough that claiming one costs little next to converting it.
+// Each thread's share of a stage is recorded with frame_profiler under
+// the stage's band name.
+//
+// Usage:
+//   depth_bands bands(pool);
+//   bands.filter(filter, depth, filtered);
+//   bands.unproject(unprojector, filtered, vertices);
+//   count = bands.compactTriangles(vertices, cols, rows, max_edge, indices);
+
+#ifndef FILE_DEPTH_BANDS_H_INCLUDED
+#define FILE_DEPTH_BANDS_H_INCLUDED
+
+#include "depth_filter.h"
+#include "depth_unprojector.h"
+#include "mesh_culling.h"
+#include "parallel_for.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+class depth_bands {
+public:
+  static const unsigned BAND_ROWS = 8;
+
+  explicit depth_bands(parallel_for &pool_) : pool(pool_) {}
+
+  parallel_for &getPool() { return pool; }
+
+  /* depth_filter::filter, depth and out may not overlap */
+  void filter(depth_filter &f, const uint16_t *depth, uint16_t *out) {
+    // Every spatial row needs the temporal rows around it, so the passes
+    // are two runs.
+    temporal_task temporal(f, depth);
+    pool.run(temporal, f.height(), BAND_ROWS, "filter band");
+    spatial_task spatial(f, out);
+    pool.run(spatial, f.height(), BAND_ROWS, "filter band");
+  }
+
+  /* depth_unprojector::unproject */
+  void unproject(const depth_unprojector &u, const uint16_t *depth, float *out) {
+    unproject_task task(u, depth, out);
+    pool.run(task, u.rowCount(), BAND_ROWS, "unproject band");
+  }
+
+  /* compactMeshTriangles. Bands are compacted into scratch memory, then
+     copied into indices in order. */
+  unsigned compactTriangles(const float *xyz, unsigned cols, unsigned rows,
+                            float max_edge, uint32_t *indices) {
+    if (rows < 2 || cols < 2)
+      return 0;
+    unsigned square_rows = rows - 1;
+    unsigned bands = (square_rows + BAND_ROWS - 1) / BAND_ROWS;
+    unsigned band_capacity = 6 * (cols - 1) * BAND_ROWS;
+    if (band_indices.size() < bands * band_capacity)
+      band_indices.resize(bands * band_capacity);
+    band_counts.resize(bands);
+
+    compact_task compact(*this, xyz, cols, square_rows, max_edge);
+    pool.run(compact, square_rows, BAND_ROWS, "compaction band");
+
+    // Where each band's indices go.
+    band_offsets.resize(bands);
+    unsigned total = 0;
+    for (unsigned b = 0; b < bands; ++b) {
+      band_offsets[b] = total;
+      total += band_counts[b];
+    }
+
+    gather_task gather(*this, band_capacity, indices);
+    pool.run(gather, bands, 1, "compaction band");
+    return total;
+  }
+
+  /* markCulledMeshVertices, returns vertices marked */
+  unsigned markCulledVertices(float *xyz, unsigned cols, unsigned rows, float max_edge) {
+    if (culled.size() < cols * rows)
+      culled.resize(cols * rows);
+    flag_task flag(xyz, cols, rows, max_edge, &culled.front());
+    pool.run(flag, rows, BAND_ROWS, "culling band");
+    mark_task mark(xyz, cols, &culled.front());
+    pool.run(mark, rows, BAND_ROWS, "culling band");
+    return mark.marked;
+  }
+
+  /* Copy rows of row_bytes bytes, in and out may not overlap */
+  void copyRows(const uint8_t *in, uint8_t *out, unsigned row_bytes, unsigned rows) {
+    copy_task task(in, out, row_bytes);
+    pool.run(task, rows, BAND_ROWS * 4, "copy band");
+  }
+
+private:
+  class temporal_task : public parallel_task {
+  public:
+    temporal_task(depth_filter &f_, const uint16_t *depth_) : f(f_), depth(depth_) {}
+    void run(unsigned begin, unsigned end) { f.temporalRows(depth, begin, end); }
+  private:
+    depth_filter &f;
+    const uint16_t *depth;
+  };
+
+  class spatial_task : public parallel_task {
+  public:
+    spatial_task(depth_filter &f_, uint16_t *out_) : f(f_), out(out_) {}
+    void run(unsigned begin, unsigned end) { f.spatialRows(out, begin, end); }
+  private:
+    depth_filter &f;
+    uint16_t *out;
+  };
+
+  class unproject_task : public parallel_task {
+  public:
+    unproject_task(const depth_unprojector &u_, const uint16_t *depth_, float *out_)
+    : u(u_), depth(depth_), out(out_) {}
+    void run(unsigned begin, unsigned end) {
+      u.unprojectRegion(depth, out, begin, end, 0, u.columns());
+    }
+  private:
+    const depth_unprojector &u;
+    const uint16_t *depth;
+    float *out;
+  };
+
+  // Runs are whole bands, apart from the single threaded run of all of
+  // them, so each band is compacted on its own either way.
+  class compact_task : public parallel_task {
+  public:
+    compact_task(depth_bands &bands_, const float *xyz_, unsigned cols_,
+                 unsigned square_rows_, float max_edge_)
+    : bands(bands_), xyz(xyz_), cols(cols_), square_rows(square_rows_), max_edge(max_edge_) {}
+    void run(unsigned begin, unsigned end) {
+      for (unsigned row = begin; row < end; row += BAND_ROWS) {
+        unsigned band = row / BAND_ROWS;
+        unsigned band_end = row + BAND_ROWS < square_rows ? row + BAND_ROWS : square_rows;
+        uint32_t *out = &bands.band_indices[band * 6 * (cols - 1) * BAND_ROWS];
+        bands.band_counts[band] = compactMeshTriangleRows(xyz, cols, row, band_end,
+                                                          max_edge, out);
+      }
+    }
+  private:
+    depth_bands &bands;
+    const float *xyz;
+    unsigned cols, square_rows;
+    float max_edge;
+  };
+
+  class gather_task : public parallel_task {
+  public:
+    gather_task(depth_bands &bands_, unsigned band_capacity_, uint32_t *indices_)
+    : bands(bands_), band_capacity(band_capacity_), indices(indices_) {}
+    void run(unsigned begin, unsigned end) {
+      for (unsigned b = begin; b < end; ++b)
+        memcpy(indices + bands.band_offsets[b], &bands.band_indices[b * band_capacity],
+               bands.band_counts[b] * sizeof(uint32_t));
+    }
+  private:
+    depth_bands &bands;
+    unsigned band_capacity;
+    uint32_t *indices;
+  };
+
+  class flag_task : public parallel_task {
+  public:
+    flag_task(const float *xyz_, unsigned cols_, unsigned rows_, float max_edge_,
+              uint8_t *culled_)
+    : xyz(xyz_), cols(cols_), rows(rows_), max_edge(max_edge_), culled(culled_) {}
+    void run(unsigned begin, unsigned end) {
+      flagCulledMeshRows(xyz, cols, rows, begin, end, max_edge, culled);
+    }
+  private:
+    const float *xyz;
+    unsigned cols, rows;
+    float max_edge;
+    uint8_t *culled;
+  };
+
+  class mark_task : public parallel_task {
+  public:
+    mark_task(float *xyz_, unsigned cols_, const uint8_t *culled_)
+    : xyz(xyz_), cols(cols_), culled(culled_) { marked = 0; }
+    void run(unsigned begin, unsigned end) {
+      marked.ExchangeAdd_Sync(markCulledMeshRows(xyz, cols, begin, end, culled));
+    }
+    OVR::AtomicInt<unsigned> marked;
+  private:
+    float *xyz;
+    unsigned cols;
+    const uint8_t *culled;
+  };
+
+  class copy_task : public parallel_task {
+  public:
+    copy_task(const uint8_t *in_, uint8_t *out_, unsigned row_bytes_)
+    : in(in_), out(out_), row_bytes(row_bytes_) {}
+    void run(unsigned begin, unsigned end) {
+      memcpy(out + begin * row_bytes, in + begin * row_bytes, (end - begin) * row_bytes);
+    }
+  private:
+    const uint8_t *in;
+    uint8_t *out;
+    unsigned row_bytes;
+  };
+
+  parallel_for &pool;
+  std::vector<uint32_t> band_indices;  /* BAND_ROWS square rows of room per band */
+  std::vector<unsigned> band_counts;   /* indices each band wrote */
+  std::vector<unsigned> band_offsets;  /* where each band's indices go */
+  std::vector<uint8_t> culled;         /* flags of markCulledVertices */
+};
+
+#endif //#ifndef FILE_DEPTH_BANDS_H_INCLUDED
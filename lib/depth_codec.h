@@ -0,0 +1,251 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// depth_codec.h
+// Lossless compression for raw Kinect depth frames.
+// There is no associated source file.
+//
+// Each row is split into alternating runs of valid and invalid pixels.
+// Invalid pixels cost nothing beyond their run length. Valid pixels are
+// predicted from the previous valid pixel in the row (the first one in a
+// row from the first valid pixel of the row above), and the zigzagged
+// prediction errors are bit packed in blocks of 32 at the width of the
+// block's largest error. Kinect noise is a few disparity steps, so most
+// blocks pack at 2 to 4 bits per pixel.
+//
+// Encoded frame:
+//   uint32 run bytes, run lengths as varints (per row: valid, invalid,
+//   valid, ... until the row is covered), then the packed blocks, each a
+//   width byte followed by 32 * width bits (the last block may be short).
+
+#ifndef FILE_DEPTH_CODEC_H_INCLUDED
+#define FILE_DEPTH_CODEC_H_INCLUDED
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+class depth_codec {
+public:
+  static const int BLOCK = 32;  /* Prediction errors per packed block */
+
+  // w, h:          dimensions of depth image
+  // invalid_depth: disparities at or above this value have no depth, they
+  //                all decode as invalid_depth
+  depth_codec(int w_, int h_, uint16_t invalid_depth)
+  : w(w_), h(h_), invalid(invalid_depth)
+  {
+    residuals.reserve(w * h);
+  }
+
+  /* Compress a w x h frame into out, replacing its contents.
+     Returns the encoded size in bytes. */
+  size_t encode(const uint16_t *depth, std::vector<uint8_t> &out) {
+    out.resize(4);
+    residuals.clear();
+
+    int row_pred = 0;  // First valid value of the row above
+    for (int y = 0; y < h; ++y) {
+      const uint16_t *row = depth + y * w;
+      int pred = row_pred;
+      bool first = true;
+      int x = 0;
+      while (x < w) {
+        // Valid run, possibly empty.
+        int start = x;
+        for (; x < w && row[x] < invalid; ++x) {
+          residuals.push_back(zigzag(row[x] - pred));
+          pred = row[x];
+          if (first) {
+            row_pred = pred;
+            first = false;
+          }
+        }
+        putVarint(out, x - start);
+        if (x == w)
+          break;
+
+        // Invalid run, never empty here.
+        start = x;
+        while (x < w && row[x] >= invalid)
+          ++x;
+        putVarint(out, x - start);
+      }
+    }
+
+    uint32_t run_bytes = out.size() - 4;
+    memcpy(&out.front(), &run_bytes, 4);
+
+    // Each block is at most a width byte and BLOCK 32 bit values.
+    size_t packed_at = out.size();
+    out.resize(packed_at + (residuals.size() / BLOCK + 1) * (1 + 4 * BLOCK));
+    uint8_t *packed = &out.front() + packed_at;
+    for (size_t i = 0; i < residuals.size(); i += BLOCK) {
+      size_t n = residuals.size() - i < size_t(BLOCK) ? residuals.size() - i : BLOCK;
+      packed = packBlock(&residuals[i], n, packed);
+    }
+    out.resize(packed - &out.front());
+    return out.size();
+  }
+
+  /* Decompress bytes of encoded data into a w x h frame.
+     Returns false if the data is corrupt. */
+  bool decode(const uint8_t *in, size_t bytes, uint16_t *depth) {
+    uint32_t run_bytes;
+    if (bytes < 4)
+      return false;
+    memcpy(&run_bytes, in, 4);
+    if (run_bytes > bytes - 4)
+      return false;
+    const uint8_t *runs = in + 4;
+    const uint8_t *runs_end = runs + run_bytes;
+    const uint8_t *packed = runs_end;
+    const uint8_t *packed_end = in + bytes;
+
+    // Unpacked prediction errors of the current block.
+    uint32_t block[BLOCK];
+    int block_left = 0;
+    int block_at = 0;
+
+    int row_pred = 0;
+    for (int y = 0; y < h; ++y) {
+      uint16_t *row = depth + y * w;
+      int pred = row_pred;
+      bool first = true;
+      int x = 0;
+      while (x < w) {
+        uint32_t valid;
+        if (!getVarint(runs, runs_end, valid) || valid > uint32_t(w - x))
+          return false;
+        for (uint32_t i = 0; i < valid; ++i, ++x) {
+          if (block_left == 0) {
+            if (!unpackBlock(packed, packed_end, block))
+              return false;
+            block_left = BLOCK;
+            block_at = 0;
+          }
+          --block_left;
+          pred += unzigzag(block[block_at++]);
+          row[x] = pred;
+          if (first) {
+            row_pred = pred;
+            first = false;
+          }
+        }
+        if (x == w)
+          break;
+
+        uint32_t invalid_run;
+        if (!getVarint(runs, runs_end, invalid_run) || invalid_run > uint32_t(w - x))
+          return false;
+        for (uint32_t i = 0; i < invalid_run; ++i)
+          row[x++] = invalid;
+      }
+    }
+    return true;
+  }
+
+  int width() const { return w; }
+  int height() const { return h; }
+
+private:
+  static uint32_t zigzag(int v) { return (uint32_t(v) << 1) ^ uint32_t(v >> 31); }
+  static int unzigzag(uint32_t u) { return int(u >> 1) ^ -int(u & 1); }
+
+  static void putVarint(std::vector<uint8_t> &out, uint32_t v) {
+    while (v >= 0x80) {
+      out.push_back(uint8_t(v) | 0x80);
+      v >>= 7;
+    }
+    out.push_back(uint8_t(v));
+  }
+
+  static bool getVarint(const uint8_t *&in, const uint8_t *end, uint32_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      if (in == end)
+        return false;
+      uint8_t byte = *in++;
+      v |= uint32_t(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  /* Pack n values at the width of the largest, return end of output */
+  static uint8_t *packBlock(const uint32_t *values, size_t n, uint8_t *out) {
+    uint32_t all = 0;
+    for (size_t i = 0; i < n; ++i)
+      all |= values[i];
+    int bits = 0;
+    while (all >> bits)
+      ++bits;
+
+    *out++ = bits;
+    uint64_t acc = 0;
+    int filled = 0;
+    for (size_t i = 0; i < n; ++i) {
+      acc |= uint64_t(values[i]) << filled;
+      filled += bits;
+      while (filled >= 8) {
+        *out++ = uint8_t(acc);
+        acc >>= 8;
+        filled -= 8;
+      }
+    }
+    if (filled > 0)
+      *out++ = uint8_t(acc);
+    return out;
+  }
+
+  /* Unpack a block of BLOCK values. A short final block unpacks garbage
+     past its end, which the decoder never reads. */
+  static bool unpackBlock(const uint8_t *&in, const uint8_t *end, uint32_t *values) {
+    if (in == end)
+      return false;
+    int bits = *in++;
+    if (bits > 32)
+      return false;
+    uint32_t mask = bits == 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+    uint64_t acc = 0;
+    int filled = 0;
+    for (int i = 0; i < BLOCK; ++i) {
+      while (filled < bits) {
+        acc |= uint64_t(in < end ? *in : 0) << filled;
+        if (in < end) ++in;
+        filled += 8;
+      }
+      values[i] = uint32_t(acc) & mask;
+      acc >>= bits;
+      filled -= bits;
+    }
+    return true;
+  }
+
+  int w, h;
+  uint16_t invalid;
+  std::vector<uint32_t> residuals;  /* Prediction errors of frame being encoded */
+};
+
+#endif //#ifndef FILE_DEPTH_CODEC_H_INCLUDED
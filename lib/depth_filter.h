@@ -0,0 +1,311 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// depth_filter.h
+// Steadies raw Kinect disparities before they are converted to vertices.
+// There is no associated source file.
+//
+// Two passes, both in integer disparity units so the output is still a
+// raw disparity image:
+//
+// Temporal: each pixel keeps an exponential moving average of its
+// disparity, and a history of which of the last 8 frames it was valid in.
+// A pixel is output while it was valid in at least 2 of the last 4
+// frames, so pixels that flicker along edges hold their last depth instead
+// of opening holes, and single frame speckles never appear. The average
+// restarts when a pixel moves more than the motion threshold, so moving
+// things don't smear.
+//
+// Spatial: each valid pixel is averaged with its 4 neighbours, weighted
+// 4:1:1:1:1. A neighbour that is invalid, or further than the edge
+// threshold from the centre, is replaced by the centre, so depth edges
+// stay sharp.
+//
+// There are scalar and SSE2 versions, picked at runtime like
+// depth_unprojector's. They do the same 16 bit integer arithmetic, so their
+// output is bit identical. Disparities must be 11 bit (invalid_depth at
+// most 2048).
+
+#ifndef FILE_DEPTH_FILTER_H_INCLUDED
+#define FILE_DEPTH_FILTER_H_INCLUDED
+
+#include <stdint.h>
+#include <stdlib.h>  // For abs
+#include <algorithm>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define DEPTH_FILTER_X86 1
+# include <immintrin.h>
+#endif
+
+class depth_filter {
+public:
+  enum Kernel { SCALAR, SSE2 };
+
+  // w, h:          dimensions of depth image
+  // invalid_depth: disparities at or above this value have no depth
+  // shift:         weight of a new frame in the average is 1/2^shift
+  // motion:        change in disparity that restarts a pixel's average
+  // edge:          largest disparity difference of neighbours averaged
+  depth_filter(unsigned w_, unsigned h_, uint16_t invalid_depth,
+               unsigned shift_ = 2, unsigned motion = 6, unsigned edge = 3)
+  : w(w_), h(h_), invalid(invalid_depth), limit(invalid_depth << FRAC),
+    shift(shift_), motion_q(motion << STATE_FRAC), edge_q(edge << FRAC),
+    kernel(bestKernel()), state(w_ * h_), history(w_ * h_), steady(w_ * h_)
+  {
+    reset();
+  }
+
+  /* Fastest kernel this CPU can run */
+  static Kernel bestKernel() {
+#ifdef DEPTH_FILTER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) return SSE2;
+#endif
+    return SCALAR;
+  }
+
+  static const char *kernelName(Kernel k) {
+    return k == SSE2 ? "SSE2" : "scalar";
+  }
+
+  /* Force a kernel, falls back to scalar if the CPU can't run it */
+  void setKernel(Kernel k) {
+    kernel = (k <= bestKernel()) ? k : SCALAR;
+  }
+  Kernel getKernel() const { return kernel; }
+
+  /* Forget every pixel's history, as after a jump in a recording */
+  void reset() {
+    // As if every pixel was valid two frames ago and not last frame: the
+    // first frame is output right away, and no stale average is held.
+    std::fill(history.begin(), history.end(), uint8_t(2));
+    std::fill(state.begin(), state.end(), uint16_t(0));
+  }
+
+  /* Filter a w x h disparity image into out. depth and out may not
+     overlap. */
+  void filter(const uint16_t *depth, uint16_t *out) {
+    // Each spatial row needs the temporal rows above and below it.
+    for (unsigned y = 0; y < h; ++y) {
+      temporalRow(depth, y);
+      if (y > 0)
+        spatialRow(y - 1, out);
+    }
+    spatialRow(h - 1, out);
+  }
+
+  /* The two passes of filter, for splitting a frame into bands of rows.
+     temporalRows must be done for every row of a frame before spatialRows
+     is called for any. Bands of rows may be run at once, the result is the
+     same as filter's. */
+  void temporalRows(const uint16_t *depth, unsigned row_begin, unsigned row_end) {
+    for (unsigned y = row_begin; y < row_end; ++y)
+      temporalRow(depth, y);
+  }
+  void spatialRows(uint16_t *out, unsigned row_begin, unsigned row_end) {
+    for (unsigned y = row_begin; y < row_end; ++y)
+      spatialRow(y, out);
+  }
+
+  unsigned height() const { return h; }
+
+private:
+  static const unsigned FRAC = 2;        /* fraction bits of steady values */
+  static const unsigned STATE_FRAC = 4;  /* fraction bits of the averages */
+
+  void temporalRow(const uint16_t *depth, unsigned y) {
+    unsigned i = y * w;
+    unsigned end = i + w;
+#ifdef DEPTH_FILTER_X86
+    if (kernel == SSE2)
+      i = temporalSSE2(depth, i, end);
+#endif
+    temporalScalar(depth, i, end);
+  }
+
+  void spatialRow(unsigned y, uint16_t *out) {
+    const uint16_t *row = &steady[y * w];
+    const uint16_t *up = y > 0 ? row - w : row;  // Edges average with themselves.
+    const uint16_t *down = y + 1 < h ? row + w : row;
+    uint16_t *row_out = out + y * w;
+
+    spatialScalar(row, up, down, 0, w < 1 ? w : 1, row_out);
+    unsigned x = 1;
+#ifdef DEPTH_FILTER_X86
+    if (kernel == SSE2)
+      x = spatialSSE2(row, up, down, x, row_out);
+#endif
+    spatialScalar(row, up, down, x, w, row_out);
+  }
+
+  // Temporal filter of pixels [i, end). Steady values of pixels that are
+  // not output are set to limit.
+  void temporalScalar(const uint16_t *depth, unsigned i, unsigned end) {
+    for (; i < end; ++i) {
+      uint16_t s = state[i];
+      uint8_t past = history[i];
+      bool valid = depth[i] < invalid;
+      if (valid) {
+        int xq = depth[i] << STATE_FRAC;
+        int diff = xq - s;
+        if (!(past & 1) || abs(diff) > int(motion_q))
+          s = uint16_t(xq);
+        else
+          s = uint16_t(s + (diff >> shift));
+      }
+      past = uint8_t((past << 1) | (valid ? 1 : 0));
+      int recent = (past & 1) + (past >> 1 & 1) + (past >> 2 & 1) + (past >> 3 & 1);
+
+      state[i] = s;
+      history[i] = past;
+      steady[i] = recent >= 2 ? uint16_t((s + 2) >> (STATE_FRAC - FRAC)) : limit;
+    }
+  }
+
+  // Spatial filter of columns [first, end) of a row of steady values.
+  void spatialScalar(const uint16_t *row, const uint16_t *up, const uint16_t *down,
+                     unsigned first, unsigned end, uint16_t *out) const {
+    for (unsigned x = first; x < end; ++x) {
+      unsigned c = row[x];
+      if (c >= limit) {
+        out[x] = invalid;
+        continue;
+      }
+      unsigned sum = 4 * c;
+      sum += neighbour(c, x > 0 ? row[x - 1] : c);
+      sum += neighbour(c, x + 1 < w ? row[x + 1] : c);
+      sum += neighbour(c, up[x]);
+      sum += neighbour(c, down[x]);
+      out[x] = uint16_t((sum + 16) >> (3 + FRAC));
+    }
+  }
+
+  unsigned neighbour(unsigned c, unsigned n) const {
+    unsigned diff = n > c ? n - c : c - n;
+    return (n < limit && diff <= edge_q) ? n : c;
+  }
+
+#ifdef DEPTH_FILTER_X86
+  // 8 pixels at a time. Returns the first pixel left for the scalar
+  // version.
+  __attribute__((target("sse2")))
+  unsigned temporalSSE2(const uint16_t *depth, unsigned i, unsigned end) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i below_invalid = _mm_set1_epi16(short(invalid - 1));
+    const __m128i motion = _mm_set1_epi16(short(motion_q));
+    const __m128i limits = _mm_set1_epi16(short(limit));
+    const __m128i round = _mm_set1_epi16(2);
+    const __m128i low_byte = _mm_set1_epi16(0xFF);
+    const __m128i shift_count = _mm_cvtsi32_si128(int(shift));
+
+    for (; i + 8 <= end; i += 8) {
+      __m128i x = _mm_loadu_si128((const __m128i *)(depth + i));
+      __m128i s = _mm_loadu_si128((const __m128i *)&state[i]);
+      __m128i past = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)&history[i]), zero);
+
+      // x < invalid, unsigned.
+      __m128i valid = _mm_cmpeq_epi16(_mm_subs_epu16(x, below_invalid), zero);
+      __m128i xq = _mm_slli_epi16(x, STATE_FRAC);
+      __m128i diff = _mm_sub_epi16(xq, s);
+      __m128i dist = _mm_max_epi16(diff, _mm_sub_epi16(zero, diff));
+      __m128i was_valid = _mm_cmpeq_epi16(_mm_and_si128(past, one), one);
+      __m128i restart = _mm_or_si128(_mm_andnot_si128(was_valid, _mm_cmpeq_epi16(zero, zero)),
+                                     _mm_cmpgt_epi16(dist, motion));
+      __m128i average = _mm_add_epi16(s, _mm_sra_epi16(diff, shift_count));
+      __m128i updated = select(restart, xq, average);
+      s = select(valid, updated, s);
+
+      past = _mm_and_si128(_mm_or_si128(_mm_slli_epi16(past, 1), _mm_and_si128(valid, one)),
+                           low_byte);
+      __m128i recent = _mm_add_epi16(
+          _mm_add_epi16(_mm_and_si128(past, one), _mm_and_si128(_mm_srli_epi16(past, 1), one)),
+          _mm_add_epi16(_mm_and_si128(_mm_srli_epi16(past, 2), one),
+                        _mm_and_si128(_mm_srli_epi16(past, 3), one)));
+      __m128i shown = _mm_cmpgt_epi16(recent, one);
+      __m128i value = _mm_srli_epi16(_mm_add_epi16(s, round), STATE_FRAC - FRAC);
+
+      _mm_storeu_si128((__m128i *)&state[i], s);
+      _mm_storel_epi64((__m128i *)&history[i], _mm_packus_epi16(past, past));
+      _mm_storeu_si128((__m128i *)&steady[i], select(shown, value, limits));
+    }
+    return i;
+  }
+
+  // Columns from first up to the last full 8 that have a right neighbour.
+  // Returns the first column left for the scalar version.
+  __attribute__((target("sse2")))
+  unsigned spatialSSE2(const uint16_t *row, const uint16_t *up, const uint16_t *down,
+                       unsigned x, uint16_t *out) const {
+    const __m128i limits = _mm_set1_epi16(short(limit));
+    const __m128i within = _mm_set1_epi16(short(edge_q + 1));
+    const __m128i round = _mm_set1_epi16(16);
+    const __m128i invalids = _mm_set1_epi16(short(invalid));
+
+    for (; x + 9 <= w; x += 8) {
+      __m128i c = _mm_loadu_si128((const __m128i *)(row + x));
+      __m128i sum = _mm_slli_epi16(c, 2);
+      sum = _mm_add_epi16(sum, neighbours(c, _mm_loadu_si128((const __m128i *)(row + x - 1)),
+                                          limits, within));
+      sum = _mm_add_epi16(sum, neighbours(c, _mm_loadu_si128((const __m128i *)(row + x + 1)),
+                                          limits, within));
+      sum = _mm_add_epi16(sum, neighbours(c, _mm_loadu_si128((const __m128i *)(up + x)),
+                                          limits, within));
+      sum = _mm_add_epi16(sum, neighbours(c, _mm_loadu_si128((const __m128i *)(down + x)),
+                                          limits, within));
+      // Sums are at most 8 * limit, which fits unsigned 16 bits.
+      __m128i value = _mm_srli_epi16(_mm_add_epi16(sum, round), 3 + FRAC);
+      __m128i valid = _mm_cmplt_epi16(c, limits);
+      _mm_storeu_si128((__m128i *)(out + x), select(valid, value, invalids));
+    }
+    return x;
+  }
+
+  __attribute__((target("sse2")))
+  static inline __m128i neighbours(__m128i c, __m128i n, __m128i limits, __m128i within) {
+    __m128i diff = _mm_or_si128(_mm_subs_epu16(n, c), _mm_subs_epu16(c, n));
+    __m128i keep = _mm_and_si128(_mm_cmplt_epi16(n, limits), _mm_cmplt_epi16(diff, within));
+    return select(keep, n, c);
+  }
+
+  __attribute__((target("sse2")))
+  static inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+  }
+#endif
+
+  unsigned w, h;
+  uint16_t invalid;
+  uint16_t limit;               /* steady value of pixels not output */
+  unsigned shift;
+  unsigned motion_q;            /* motion threshold, in average units */
+  unsigned edge_q;              /* edge threshold, in steady units */
+  Kernel kernel;
+  std::vector<uint16_t> state;  /* moving average per pixel, STATE_FRAC bits */
+  std::vector<uint8_t> history; /* valid in each of the last 8 frames, newest in bit 0 */
+  std::vector<uint16_t> steady; /* temporal output, FRAC bits */
+};
+
+#endif //#ifndef FILE_DEPTH_FILTER_H_INCLUDED
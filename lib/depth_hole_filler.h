@@ -0,0 +1,214 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// depth_hole_filler.h
+// Fills small holes of invalid pixels in a Kinect disparity image by
+// push-pull, and rates every pixel with a confidence, so renderers can
+// fade what was made up.
+// There is no associated source file.
+//
+// Pull halves the image level by level. Each coarse pixel is the average
+// of its valid children, weighted by their weights; its weight is the sum
+// of theirs, at most 1. Push goes back down. Each pixel blends its own
+// value with a bilinear sample of the level above, in proportion to what
+// its own weight is missing. Measured pixels keep their value and have
+// confidence 1. Filled pixels keep fade() of their confidence for each
+// level the value came down. Holes too big for the pyramid stay invalid.
+//
+// shaders/hole_pull_f.glsl and shaders/hole_push_f.glsl do the same
+// arithmetic as GPU passes, see gpu_hole_filler.h.
+
+#ifndef FILE_DEPTH_HOLE_FILLER_H_INCLUDED
+#define FILE_DEPTH_HOLE_FILLER_H_INCLUDED
+
+#include <stdint.h>
+#include <vector>
+
+class depth_hole_filler {
+public:
+  static const unsigned DEFAULT_LEVELS = 4;  /* Fills holes up to about 2^4 pixels across */
+
+  /* Confidence a pixel filled from one level up keeps */
+  static float fade() { return 0.7f; }
+
+  // w, h:          dimensions of depth image
+  // invalid_depth: disparities at or above this value have no depth
+  // levels:        number of times the image is halved, at least 1
+  depth_hole_filler(unsigned w_, unsigned h_, uint16_t invalid_depth,
+                    unsigned levels = DEFAULT_LEVELS)
+  : w(w_), h(h_), invalid(invalid_depth), pyramid(levels > 0 ? levels : 1)
+  {
+    for (unsigned k = 0; k < pyramid.size(); ++k) {
+      w_ = (w_ + 1) / 2;
+      h_ = (h_ + 1) / 2;
+      pyramid[k].w = w_;
+      pyramid[k].h = h_;
+      pyramid[k].value.resize(w_ * h_);
+      pyramid[k].weight.resize(w_ * h_);
+    }
+  }
+
+  /* Fill the holes of depth into out, and write the confidence of every
+     pixel, 0 to 255, into confidence. Pixels left invalid have confidence
+     0. depth and out may be the same image. */
+  void fill(const uint16_t *depth, uint16_t *out, uint8_t *confidence) {
+    // The depth image itself is the bottom level, every valid pixel has
+    // weight 1.
+    pullDepth(depth, pyramid[0]);
+    for (unsigned k = 1; k < pyramid.size(); ++k)
+      pull(pyramid[k - 1], pyramid[k]);
+    for (unsigned k = pyramid.size() - 1; k > 0; --k)
+      push(pyramid[k], pyramid[k - 1]);
+    pushDepth(pyramid[0], depth, out, confidence);
+  }
+
+private:
+  struct level {
+    unsigned w, h;
+    std::vector<float> value;   /* disparity */
+    std::vector<float> weight;  /* 0 to 1 */
+  };
+
+  void pullDepth(const uint16_t *depth, level &coarse) const {
+    for (unsigned y = 0; y < coarse.h; ++y) {
+      for (unsigned x = 0; x < coarse.w; ++x) {
+        float weight = 0.0f, sum = 0.0f;
+        for (unsigned i = 0; i < 4; ++i) {
+          unsigned fx = 2 * x + (i & 1), fy = 2 * y + (i >> 1);
+          if (fx < w && fy < h && depth[fy * w + fx] < invalid) {
+            weight += 1.0f;
+            sum += float(depth[fy * w + fx]);
+          }
+        }
+        unsigned c = y * coarse.w + x;
+        coarse.value[c] = weight > 0.0f ? sum / weight : 0.0f;
+        coarse.weight[c] = weight < 1.0f ? weight : 1.0f;
+      }
+    }
+  }
+
+  // Valid pixels are copied, invalid ones are filled from coarse.
+  void pushDepth(const level &coarse, const uint16_t *depth, uint16_t *out,
+                 uint8_t *confidence) const {
+    for (unsigned y = 0; y < h; ++y) {
+      unsigned py = y / 2;
+      unsigned ny = nearest(y, coarse.h);
+      for (unsigned x = 0; x < w; ++x) {
+        unsigned i = y * w + x;
+        if (depth[i] < invalid) {
+          out[i] = depth[i];
+          confidence[i] = 255;
+          continue;
+        }
+
+        unsigned px = x / 2;
+        unsigned nx = nearest(x, coarse.w);
+        float weight = 0.0f, sum = 0.0f;
+        bilinear(coarse, px, py, nx, ny, weight, sum);
+        if (weight > 0.0f) {
+          out[i] = uint16_t(sum / weight + 0.5f);
+          confidence[i] = uint8_t(weight * fade() * 255.0f + 0.5f);
+        } else {
+          out[i] = invalid;
+          confidence[i] = 0;
+        }
+      }
+    }
+  }
+
+  static void pull(const level &fine, level &coarse) {
+    for (unsigned y = 0; y < coarse.h; ++y) {
+      for (unsigned x = 0; x < coarse.w; ++x) {
+        float weight = 0.0f, sum = 0.0f;
+        for (unsigned i = 0; i < 4; ++i) {
+          unsigned fx = 2 * x + (i & 1), fy = 2 * y + (i >> 1);
+          if (fx < fine.w && fy < fine.h) {
+            unsigned f = fy * fine.w + fx;
+            weight += fine.weight[f];
+            sum += fine.value[f] * fine.weight[f];
+          }
+        }
+        unsigned c = y * coarse.w + x;
+        coarse.value[c] = weight > 0.0f ? sum / weight : 0.0f;
+        coarse.weight[c] = weight < 1.0f ? weight : 1.0f;
+      }
+    }
+  }
+
+  // Fill in fine from coarse, which has already been pushed.
+  static void push(const level &coarse, level &fine) {
+    for (unsigned y = 0; y < fine.h; ++y) {
+      unsigned py = y / 2;
+      unsigned ny = nearest(y, coarse.h);
+      for (unsigned x = 0; x < fine.w; ++x) {
+        unsigned f = y * fine.w + x;
+        float own = fine.weight[f];
+        if (own >= 1.0f)
+          continue;
+
+        unsigned px = x / 2;
+        unsigned nx = nearest(x, coarse.w);
+        float weight = 0.0f, sum = 0.0f;
+        bilinear(coarse, px, py, nx, ny, weight, sum);
+
+        float total = own + (1.0f - own) * weight;
+        if (total > 0.0f) {
+          fine.value[f] = (own * fine.value[f] + (1.0f - own) * sum) / total;
+          fine.weight[f] = own + (1.0f - own) * weight * fade();
+        }
+      }
+    }
+  }
+
+  // The coarse pixel next to the parent of fine pixel x, on x's side.
+  static unsigned nearest(unsigned x, unsigned coarse_size) {
+    unsigned parent = x / 2;
+    if (x & 1)
+      return parent + 1 < coarse_size ? parent + 1 : parent;
+    return parent > 0 ? parent - 1 : 0;
+  }
+
+  // Weighted sum of the parent (px, py) and its nearest neighbours, 3/4
+  // and 1/4 in each direction.
+  static void bilinear(const level &l, unsigned px, unsigned py, unsigned nx, unsigned ny,
+                       float &weight, float &sum) {
+    tap(l, px, py, 0.5625f, weight, sum);
+    tap(l, nx, py, 0.1875f, weight, sum);
+    tap(l, px, ny, 0.1875f, weight, sum);
+    tap(l, nx, ny, 0.0625f, weight, sum);
+  }
+
+  static void tap(const level &l, unsigned x, unsigned y, float bilinear,
+                  float &weight, float &sum) {
+    unsigned i = y * l.w + x;
+    float weighted = bilinear * l.weight[i];
+    weight += weighted;
+    sum += weighted * l.value[i];
+  }
+
+  unsigned w, h;
+  uint16_t invalid;
+  std::vector<level> pyramid;  /* pyramid[0] is half size */
+};
+
+#endif //#ifndef FILE_DEPTH_HOLE_FILLER_H_INCLUDED
@@ -0,0 +1,170 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// depth_tiles.h
+// Finds the parts of a Kinect depth image that changed since the last
+// frame, in 16x16 pixel tiles, so only those need converting and uploading.
+// There is no associated source file.
+//
+// A tile is dirty when any of its pixels moved more than the tolerance
+// (in raw disparity units) or became valid or invalid. The tracker keeps
+// a reference image holding each tile as it was when last dirty; convert
+// from the reference rather than the incoming frame, so clean tiles and
+// dirty ones always come from the same pixels. Small changes that add up
+// past the tolerance make the tile dirty.
+//
+// Usage, once per frame:
+//   unsigned dirty = tiles.update(depth);
+//   depth_tiles::meshRegions(w, h, tiles.dirty(), stride, regions);
+//   for each region: convert those rows and columns of tiles.reference()
+
+#ifndef FILE_DEPTH_TILES_H_INCLUDED
+#define FILE_DEPTH_TILES_H_INCLUDED
+
+#include <stdint.h>
+#include <stdlib.h>  // For abs
+#include <string.h>  // For memcpy
+#include <vector>
+
+// Rows [row_begin, row_end) and columns [col_begin, col_end) of a mesh.
+struct mesh_region {
+  unsigned row_begin, row_end;
+  unsigned col_begin, col_end;
+};
+
+class depth_tiles {
+public:
+  static const unsigned TILE = 16;  /* Tile width and height in pixels */
+
+  // w, h:          dimensions of depth image
+  // invalid_depth: disparities at or above this value have no depth
+  // tolerance:     largest change of a pixel that leaves its tile clean
+  depth_tiles(unsigned w_, unsigned h_, uint16_t invalid_depth, unsigned tolerance_)
+  : w(w_), h(h_), tiles_x((w_ + TILE - 1) / TILE), tiles_y((h_ + TILE - 1) / TILE),
+    invalid(invalid_depth), tolerance(tolerance_),
+    reference_image(w_ * h_), dirty_tiles(tiles_x * tiles_y, 1), first(true)
+  {}
+
+  unsigned tileColumns() const { return tiles_x; }
+  unsigned tileRows() const { return tiles_y; }
+  unsigned tileCount() const { return tiles_x * tiles_y; }
+
+  /* Compare depth with the reference, and copy the tiles that changed
+     into it. Returns the number of dirty tiles, which dirty() flags. The
+     first frame is all dirty. */
+  unsigned update(const uint16_t *depth) {
+    unsigned count = 0;
+    for (unsigned ty = 0; ty < tiles_y; ++ty) {
+      for (unsigned tx = 0; tx < tiles_x; ++tx) {
+        bool changed = first || tileChanged(depth, tx, ty);
+        dirty_tiles[ty * tiles_x + tx] = changed;
+        if (changed) {
+          copyTile(depth, tx, ty);
+          ++count;
+        }
+      }
+    }
+    first = false;
+    return count;
+  }
+
+  /* Make every tile dirty on the next update */
+  void invalidate() { first = true; }
+
+  /* One flag per tile, row by row, set if it changed in the last update */
+  const uint8_t *dirty() const { return &dirty_tiles.front(); }
+
+  /* The depth image as of each tile's last change */
+  const uint16_t *reference() const { return &reference_image.front(); }
+
+  /* Regions of a mesh built from every stride-th pixel of a w x h image
+     that tiles flagged in mask cover. Neighbouring flagged tiles in a tile
+     row are one region. stride must divide TILE. */
+  static void meshRegions(unsigned w, unsigned h, const uint8_t *mask, unsigned stride,
+                          std::vector<mesh_region> &regions) {
+    const unsigned tiles_x = (w + TILE - 1) / TILE;
+    const unsigned tiles_y = (h + TILE - 1) / TILE;
+    const unsigned cols = (w + stride - 1) / stride;
+    const unsigned rows = (h + stride - 1) / stride;
+    const unsigned step = TILE / stride;  /* mesh vertices per tile */
+
+    regions.clear();
+    for (unsigned ty = 0; ty < tiles_y; ++ty) {
+      const uint8_t *row = mask + ty * tiles_x;
+      for (unsigned tx = 0; tx < tiles_x; ) {
+        if (!row[tx]) {
+          ++tx;
+          continue;
+        }
+        unsigned end = tx + 1;
+        while (end < tiles_x && row[end])
+          ++end;
+
+        mesh_region region;
+        region.row_begin = ty * step;
+        region.row_end = (ty + 1) * step < rows ? (ty + 1) * step : rows;
+        region.col_begin = tx * step;
+        region.col_end = end * step < cols ? end * step : cols;
+        regions.push_back(region);
+        tx = end;
+      }
+    }
+  }
+
+private:
+  /* Whether a tile of depth differs from the reference */
+  bool tileChanged(const uint16_t *depth, unsigned tx, unsigned ty) const {
+    unsigned x_end = (tx + 1) * TILE < w ? (tx + 1) * TILE : w;
+    unsigned y_end = (ty + 1) * TILE < h ? (ty + 1) * TILE : h;
+    for (unsigned y = ty * TILE; y < y_end; ++y) {
+      const uint16_t *now = depth + y * w;
+      const uint16_t *then = &reference_image[y * w];
+      for (unsigned x = tx * TILE; x < x_end; ++x) {
+        if ((now[x] >= invalid) != (then[x] >= invalid))
+          return true;
+        if (unsigned(abs(int(now[x]) - int(then[x]))) > tolerance && now[x] < invalid)
+          return true;
+      }
+    }
+    return false;
+  }
+
+  void copyTile(const uint16_t *depth, unsigned tx, unsigned ty) {
+    unsigned x_begin = tx * TILE;
+    unsigned x_end = (tx + 1) * TILE < w ? (tx + 1) * TILE : w;
+    unsigned y_end = (ty + 1) * TILE < h ? (ty + 1) * TILE : h;
+    for (unsigned y = ty * TILE; y < y_end; ++y)
+      memcpy(&reference_image[y * w + x_begin], depth + y * w + x_begin,
+             (x_end - x_begin) * sizeof(uint16_t));
+  }
+
+  unsigned w, h;
+  unsigned tiles_x, tiles_y;
+  uint16_t invalid;
+  unsigned tolerance;
+  std::vector<uint16_t> reference_image;
+  std::vector<uint8_t> dirty_tiles;
+  bool first;  /* Next update makes every tile dirty */
+};
+
+#endif //#ifndef FILE_DEPTH_TILES_H_INCLUDED
@@ -0,0 +1,288 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// depth_unprojector.h
+// Converts a raw Kinect disparity image into packed x,y,z float vertices.
+// There is no associated source file.
+//
+// Every stride-th pixel of every stride-th row becomes one vertex, written
+// as three consecutive floats, row by row. Invalid pixels become (0,0,0).
+//
+// There are scalar, SSE2 and AVX2 versions of the conversion. Which is
+// fastest depends on the stride as well as the CPU (the SIMD lookups gain
+// little on sparse rows), so the first time each stride is used every
+// kernel the CPU supports is timed on a test frame and the fastest kept.
+// All of them do the same float multiplies on the same table values, so
+// their output is bit identical, which lets the scalar version serve as a
+// reference.
+
+#ifndef FILE_DEPTH_UNPROJECTOR_H_INCLUDED
+#define FILE_DEPTH_UNPROJECTOR_H_INCLUDED
+
+#include "kinect_depth_tables.h"
+
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define DEPTH_UNPROJECTOR_X86 1
+# include <immintrin.h>
+#endif
+
+class depth_unprojector {
+public:
+  enum Kernel { SCALAR, SSE2, AVX2 };
+
+  depth_unprojector(const kinect_depth_tables &tables_, unsigned stride_ = 2)
+  : tables(tables_), kernel(SCALAR), forced(false)
+  {
+    setStride(stride_);
+  }
+
+  /* Widest kernel this CPU can run */
+  static Kernel bestKernel() {
+#ifdef DEPTH_UNPROJECTOR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return AVX2;
+    if (__builtin_cpu_supports("sse2")) return SSE2;
+#endif
+    return SCALAR;
+  }
+
+  static const char *kernelName(Kernel k) {
+    switch (k) {
+      case AVX2: return "AVX2";
+      case SSE2: return "SSE2";
+      default:   return "scalar";
+    }
+  }
+
+  /* Force a kernel for every stride, falls back to scalar if the CPU
+     can't run it */
+  void setKernel(Kernel k) {
+    forced = true;
+    kernel = (k <= bestKernel()) ? k : SCALAR;
+  }
+  /* Go back to the fastest kernel for each stride */
+  void useFastestKernel() {
+    forced = false;
+    kernel = fastestKernel();
+  }
+  Kernel getKernel() const { return kernel; }
+
+  /* Use every stride-th pixel in x and y */
+  void setStride(unsigned stride_) {
+    stride = stride_ ? stride_ : 1;
+    cols = (tables.width()  + stride - 1) / stride;
+    rows = (tables.height() + stride - 1) / stride;
+
+    // X ray component of each output column, contiguous so the SIMD
+    // kernels can load it directly.
+    ray_x.resize(cols);
+    for (unsigned c = 0; c < cols; ++c)
+      ray_x[c] = tables.rayX(c * stride);
+
+    if (!forced)
+      kernel = fastestKernel();
+  }
+  unsigned getStride() const { return stride; }
+
+  unsigned columns() const { return cols; }
+  unsigned rowCount() const { return rows; }
+
+  /* Number of vertices (not floats) written by unproject() */
+  unsigned vertexCount() const { return cols * rows; }
+
+  /* Convert depth image into vertexCount()*3 floats at out */
+  void unproject(const uint16_t *depth, float *out) const {
+    unprojectRegion(depth, out, 0, rows, 0, cols);
+  }
+
+  /* Convert only vertex rows [row_begin, row_end) and columns
+     [col_begin, col_end), leaving the rest of out as it was. Gives the same
+     floats as unproject() for those vertices. */
+  void unprojectRegion(const uint16_t *depth, float *out,
+                       unsigned row_begin, unsigned row_end,
+                       unsigned col_begin, unsigned col_end) const {
+    for (unsigned r = row_begin; r < row_end; ++r) {
+      unsigned y = r * stride;
+      const uint16_t *row = depth + y * tables.width();
+      float *row_out = out + r * cols * 3;
+
+      switch (kernel) {
+#ifdef DEPTH_UNPROJECTOR_X86
+        case AVX2: unprojectRowAVX2(row, tables.rayY(y), col_begin, col_end, row_out); break;
+        case SSE2: unprojectRowSSE2(row, tables.rayY(y), col_begin, col_end, row_out); break;
+#endif
+        default:   unprojectRowScalar(row, tables.rayY(y), col_begin, col_end, row_out); break;
+      }
+    }
+  }
+
+private:
+  static const int CALIBRATION_RUNS = 3;
+  static const uint64_t CALIBRATION_NANOS = 2000000;
+
+  // Kernel for the current stride, timing the supported kernels the first
+  // time the stride is seen.
+  Kernel fastestKernel() {
+    if (stride >= stride_kernels.size())
+      stride_kernels.resize(stride + 1, -1);
+    if (stride_kernels[stride] < 0)
+      stride_kernels[stride] = calibrate();
+    return Kernel(stride_kernels[stride]);
+  }
+
+  // Best of at least CALIBRATION_RUNS conversions of a test frame with each
+  // kernel, running for at least CALIBRATION_NANOS so small strides aren't
+  // timed on one noisy sample.
+  Kernel calibrate() {
+    std::vector<uint16_t> depth(tables.width() * tables.height());
+    for (unsigned i = 0; i < depth.size(); ++i)
+      depth[i] = uint16_t((i * 7 + i / tables.width() * 3) % kinect_depth_tables::DISPARITY_LEVELS);
+    std::vector<float> out(vertexCount() * 3);
+
+    Kernel fastest = SCALAR;
+    uint64_t fastest_ns = ~uint64_t(0);
+    for (int k = SCALAR; k <= bestKernel(); ++k) {
+      kernel = Kernel(k);
+      uint64_t begin = nanos(), start = begin;
+      for (int run = 0; run < CALIBRATION_RUNS || start - begin < CALIBRATION_NANOS; ++run) {
+        unproject(&depth.front(), &out.front());
+        uint64_t end = nanos();
+        if (end - start < fastest_ns) {
+          fastest_ns = end - start;
+          fastest = kernel;
+        }
+        start = end;
+      }
+    }
+    return fastest;
+  }
+
+  static uint64_t nanos() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+  }
+
+  // Scalar conversion of output columns [first, end) of one row.
+  void unprojectRowScalar(const uint16_t *row, float ray_y, unsigned first,
+                          unsigned end, float *out) const {
+    out += first * 3;
+    for (unsigned c = first; c < end; ++c) {
+      float d = tables.meters(row[c * stride]);
+      *out++ = ray_x[c] * d;
+      *out++ = ray_y * d;
+      *out++ = d;
+    }
+  }
+
+#ifdef DEPTH_UNPROJECTOR_X86
+  // Interleave 4 x, 4 y and 4 z values into 12 packed floats.
+  static inline void storeXYZ(float *out, __m128 x, __m128 y, __m128 z) {
+    __m128 xy_lo = _mm_unpacklo_ps(x, y);                           // x0 y0 x1 y1
+    __m128 xy_hi = _mm_unpackhi_ps(x, y);                           // x2 y2 x3 y3
+    __m128 zx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1,1,0,0));         // z0 z0 x1 x1
+    __m128 yz = _mm_shuffle_ps(xy_lo, z, _MM_SHUFFLE(1,1,3,3));     // y1 y1 z1 z1
+    __m128 zxy = _mm_shuffle_ps(z, xy_hi, _MM_SHUFFLE(3,2,3,2));    // z2 z3 x3 y3
+    _mm_storeu_ps(out,     _mm_shuffle_ps(xy_lo, zx, _MM_SHUFFLE(2,0,1,0)));  // x0 y0 z0 x1
+    _mm_storeu_ps(out + 4, _mm_shuffle_ps(yz, xy_hi, _MM_SHUFFLE(1,0,2,0)));  // y1 z1 x2 y2
+    _mm_storeu_ps(out + 8, _mm_shuffle_ps(zxy, zxy, _MM_SHUFFLE(1,3,2,0)));   // z2 x3 y3 z3
+  }
+
+  // SSE2 has no gather, so the table lookups stay scalar; the multiplies
+  // and the interleaving into x,y,z triples are done 4 at a time.
+  __attribute__((target("sse2")))
+  void unprojectRowSSE2(const uint16_t *row, float ray_y, unsigned first,
+                        unsigned end, float *out) const {
+    const float *meters = tables.metersTable();
+    const int last = kinect_depth_tables::DISPARITY_LEVELS - 1;
+    __m128 ry = _mm_set1_ps(ray_y);
+
+    unsigned c = first;
+    for (; c + 4 <= end; c += 4) {
+      const uint16_t *p = row + c * stride;
+      unsigned d0 = p[0], d1 = p[stride], d2 = p[2*stride], d3 = p[3*stride];
+      __m128 d = _mm_set_ps(meters[d3 < last ? d3 : last], meters[d2 < last ? d2 : last],
+                            meters[d1 < last ? d1 : last], meters[d0 < last ? d0 : last]);
+      __m128 rx = _mm_loadu_ps(&ray_x[c]);
+      storeXYZ(out + c * 3, _mm_mul_ps(rx, d), _mm_mul_ps(ry, d), d);
+    }
+    unprojectRowScalar(row, ray_y, c, end, out);
+  }
+
+  // AVX2 loads 8 disparities at a time and gathers their depths from the
+  // table.
+  __attribute__((target("avx2")))
+  void unprojectRowAVX2(const uint16_t *row, float ray_y, unsigned first,
+                        unsigned end, float *out) const {
+    const float *meters = tables.metersTable();
+    const __m256i last = _mm256_set1_epi32(kinect_depth_tables::DISPARITY_LEVELS - 1);
+    const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+    const __m256i offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i gather_step = _mm256_mullo_epi32(offsets, _mm256_set1_epi32(stride));
+    __m256 ry = _mm256_set1_ps(ray_y);
+
+    unsigned c = first;
+    for (; c + 8 <= end; c += 8) {
+      const uint16_t *p = row + c * stride;
+      __m256i disp;
+      if (stride == 1) {
+        disp = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)p));
+      } else if (stride == 2) {
+        // Even 16 bit lanes are the low halves of the 32 bit lanes.
+        disp = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)p), low16);
+      } else {
+        // Gather 32 bits starting at each sample, keep the low 16. The last
+        // read ends 2 bytes after the last sample, still inside the row.
+        disp = _mm256_and_si256(_mm256_i32gather_epi32((const int *)p, gather_step, 2), low16);
+      }
+      disp = _mm256_min_epi32(disp, last);
+
+      __m256 d = _mm256_i32gather_ps(meters, disp, 4);
+      __m256 x = _mm256_mul_ps(_mm256_loadu_ps(&ray_x[c]), d);
+      __m256 y = _mm256_mul_ps(ry, d);
+
+      storeXYZ(out + c * 3,      _mm256_castps256_ps128(x),
+                                 _mm256_castps256_ps128(y),
+                                 _mm256_castps256_ps128(d));
+      storeXYZ(out + c * 3 + 12, _mm256_extractf128_ps(x, 1),
+                                 _mm256_extractf128_ps(y, 1),
+                                 _mm256_extractf128_ps(d, 1));
+    }
+    unprojectRowScalar(row, ray_y, c, end, out);
+  }
+#endif
+
+  const kinect_depth_tables &tables;
+  Kernel kernel;
+  bool forced;               /* set by setKernel(), skips calibration */
+  std::vector<signed char> stride_kernels;  /* fastest kernel per stride, -1 not timed yet */
+  unsigned stride;
+  unsigned cols, rows;       /* dimensions of output vertex grid */
+  std::vector<float> ray_x;  /* X ray component per output column */
+};
+
+#endif //#ifndef FILE_DEPTH_UNPROJECTOR_H_INCLUDED
@@ -0,0 +1,215 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// depth_worker.h
+// Converts one Kinect's depth frames on a thread of its own, pinned to a
+// core, so several Kinects convert in parallel and a capture thread only
+// ever copies a frame.
+// There is no associated source file.
+// Requires pthreads and LibOVR's Kernel/OVR_Atomic.h.
+//
+// The capture thread copies each frame into a free buffer and swaps it in
+// as the pending frame. The worker swaps the pending frame out and converts
+// it. Frames the worker did not get to before the next one are dropped, so
+// a slow conversion never backs up a live Kinect. Recordings and made up
+// frames can instead wait for the worker, so none are dropped.
+//
+// Usage:
+//   class device : public depth_worker::converter {
+//     void convertDepth(const uint16_t *depth, uint64_t capture_nanos);
+//   };
+//   worker.start(&dev, core, "depth 0", false);
+//   capture thread:  worker.submit(depth, capture_nanos);
+//   worker.stop();
+
+#ifndef FILE_DEPTH_WORKER_H_INCLUDED
+#define FILE_DEPTH_WORKER_H_INCLUDED
+
+#include "frame_profiler.h"
+#include "Kernel/OVR_Atomic.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+class depth_worker {
+public:
+  // What the worker runs every frame through.
+  class converter {
+  public:
+    virtual ~converter() {}
+    virtual void convertDepth(const uint16_t *depth, uint64_t capture_nanos) = 0;
+  };
+
+  // pixels: size of every depth frame
+  explicit depth_worker(unsigned pixels)
+  : incoming(pixels), pending(pixels), working(pixels),
+    pending_nanos(0), has_pending(false), stopping(false),
+    lossless(false), target(NULL), name(NULL), core(-1), dropped_frames(0)
+  {
+    running = 0;
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&changed, NULL);
+  }
+
+  ~depth_worker() {
+    stop();
+    pthread_cond_destroy(&changed);
+    pthread_mutex_destroy(&lock);
+  }
+
+  /* Start converting submitted frames with c on a new thread, pinned to
+     core (modulo the core count), or anywhere for a negative core. name
+     labels the thread in frame traces and must outlive the profiler.
+     With wait_for_worker, submit blocks instead of dropping frames.
+     Returns false if the thread could not be created. */
+  bool start(converter *c, int core_, const char *name_, bool wait_for_worker) {
+    if (running.Load_Acquire())
+      return true;
+    target = c;
+    core = core_;
+    name = name_;
+    lossless = wait_for_worker;
+    stopping = false;
+    has_pending = false;
+    bool created = pthread_create(&thread, NULL, &depth_worker::threadFunc, this) == 0;
+    running.Store_Release(created);
+    return created;
+  }
+
+  /* Convert the frame being worked on, then stop. Pending frames are dropped. */
+  void stop() {
+    if (!running.Load_Acquire())
+      return;
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+    pthread_join(thread, NULL);
+    running.Store_Release(0);
+  }
+
+  /* Capture thread: hand over a copy of depth. Replaces a pending frame
+     the worker has not started on yet, unless waiting for the worker. */
+  void submit(const uint16_t *depth, uint64_t capture_nanos) {
+    {
+      profile_scope scope("depth copy");
+      std::copy(depth, depth + incoming.size(), incoming.begin());
+    }
+
+    pthread_mutex_lock(&lock);
+    if (lossless) {
+      profile_scope scope("depth worker wait");
+      while (has_pending && !stopping)
+        pthread_cond_wait(&changed, &lock);
+    }
+    if (has_pending)
+      dropped_frames += 1;
+    incoming.swap(pending);
+    pending_nanos = capture_nanos;
+    has_pending = true;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+  }
+
+  /* Frames replaced before the worker got to them */
+  unsigned dropped() {
+    pthread_mutex_lock(&lock);
+    unsigned count = dropped_frames;
+    pthread_mutex_unlock(&lock);
+    return count;
+  }
+
+  /* May be called from any thread, such as the capture thread */
+  bool isRunning() const { return running.Load_Acquire() != 0; }
+
+  /* Number of cores this process may run on, at least 1 */
+  static int coreCount() {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0)
+      return CPU_COUNT(&set);
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 0 ? int(online) : 1;
+  }
+
+private:
+  static void *threadFunc(void *arg) {
+    static_cast<depth_worker*>(arg)->run();
+    return NULL;
+  }
+
+  /* Pin the calling thread to core, modulo the core count */
+  static void pinToCore(int core) {
+    if (core < 0)
+      return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % coreCount(), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  }
+
+  void run() {
+    if (name)
+      frame_profiler::nameThread(name);
+    pinToCore(core);
+
+    for (;;) {
+      uint64_t capture_nanos;
+      pthread_mutex_lock(&lock);
+      while (!has_pending && !stopping)
+        pthread_cond_wait(&changed, &lock);
+      if (stopping) {
+        pthread_mutex_unlock(&lock);
+        return;
+      }
+      working.swap(pending);
+      capture_nanos = pending_nanos;
+      has_pending = false;
+      pthread_cond_broadcast(&changed);  // A waiting submit may go on.
+      pthread_mutex_unlock(&lock);
+
+      target->convertDepth(&working.front(), capture_nanos);
+    }
+  }
+
+  std::vector<uint16_t> incoming;  /* capture thread only */
+  std::vector<uint16_t> pending;   /* latest submitted frame, under lock */
+  std::vector<uint16_t> working;   /* worker only */
+  uint64_t pending_nanos;
+  bool has_pending;
+  bool stopping;
+  OVR::AtomicInt<int> running;  /* read by the capture thread */
+  bool lossless;
+  converter *target;
+  const char *name;
+  int core;
+  unsigned dropped_frames;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t changed;  /* a frame was submitted, taken, or stopping */
+};
+
+#endif //#ifndef FILE_DEPTH_WORKER_H_INCLUDED
@@ -0,0 +1,250 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// frame_profiler.h
+// Records how long each stage of a frame took, on every thread, and
+// writes the history as a Chrome trace (chrome://tracing, or Perfetto).
+// There is no associated source file.
+// Requires LibOVR's Kernel/OVR_Atomic.h.
+//
+// Each thread records into its own ring of the last RING_EVENTS timings,
+// so recording never locks or allocates after a thread's first timing.
+// Old timings are overwritten, the trace holds the most recent ones.
+// Averages hide single frame spikes; the trace shows every frame.
+//
+// Usage:
+//   frame_profiler::nameThread("depth");   // optional, once per thread
+//   { profile_scope scope("depth conversion"); convert(); }
+//   frame_profiler::writeChromeTrace("frame_trace.json");
+//
+// Timings measured elsewhere, like on the GPU, go on a track of their own:
+//   int gpu = frame_profiler::addTrack("gpu");
+//   frame_profiler::recordTrack(gpu, "mesh", start, duration);
+//
+// Names must be string literals, or otherwise outlive the profiler.
+
+#ifndef FILE_FRAME_PROFILER_H_INCLUDED
+#define FILE_FRAME_PROFILER_H_INCLUDED
+
+#include "Kernel/OVR_Atomic.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+class frame_profiler {
+public:
+  static const unsigned RING_EVENTS = 16384;  /* Timings kept per thread */
+  static const int MAX_THREADS = 32;  /* Threads and tracks */
+
+  struct event {
+    const char *name;
+    uint64_t start;     /* nanoseconds */
+    uint64_t duration;  /* nanoseconds */
+  };
+
+  /* Monotonic time in nanoseconds */
+  static uint64_t nanos() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+  }
+
+  /* Name this thread's track in the trace */
+  static void nameThread(const char *name) {
+    ring *r = threadRing();
+    if (r) r->name = name;
+  }
+
+  /* Record a timing for this thread. Never blocks. */
+  static void record(const char *name, uint64_t start, uint64_t duration) {
+    ring *r = threadRing();
+    if (r)
+      push(r, name, start, duration);
+  }
+
+  /* Add a track for timings measured somewhere other than the calling
+     thread, such as on the GPU. Returns -1 if there is no room. Only one
+     thread may record into a track. */
+  static int addTrack(const char *name) {
+    int index;
+    ring *r = claimRing(index);
+    if (!r)
+      return -1;
+    r->name = name;
+    return index;
+  }
+
+  /* Record a timing into a track from addTrack. Never blocks. */
+  static void recordTrack(int track, const char *name, uint64_t start, uint64_t duration) {
+    if (track < 0 || track >= MAX_THREADS)
+      return;
+    ring *r = threads().rings[track].Load_Acquire();
+    if (r)
+      push(r, name, start, duration);
+  }
+
+  /* Number of threads and tracks that have recorded timings */
+  static int trackCount() {
+    int count = threads().count;
+    return count < MAX_THREADS ? count : MAX_THREADS;
+  }
+
+  /* Name of a thread or track, NULL if it has none */
+  static const char *trackName(int track) {
+    ring *r = threads().rings[track].Load_Acquire();
+    return r ? r->name : NULL;
+  }
+
+  /* Copy a thread's or track's recorded timings into out, oldest first.
+     Same caveat as writeChromeTrace about rings that lap. */
+  static void trackEvents(int track, std::vector<event> &out) {
+    out.clear();
+    ring *r = threads().rings[track].Load_Acquire();
+    if (!r)
+      return;
+    unsigned head = r->head.Load_Acquire();
+    unsigned begin = head > RING_EVENTS ? head - RING_EVENTS : 0;
+    for (unsigned i = begin; i < head; ++i)
+      out.push_back(r->events[i % RING_EVENTS]);
+  }
+
+  /* Write every thread's recorded timings as Chrome trace event JSON.
+     Returns false if the file could not be written. May be called from any
+     thread; timings recorded while it runs may be torn if a ring laps. */
+  static bool writeChromeTrace(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file)
+      return false;
+
+    registry &reg = threads();
+    int count = reg.count;
+    if (count > MAX_THREADS) count = MAX_THREADS;
+    uint64_t origin = reg.origin;
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (int t = 0; t < count; ++t) {
+      ring *r = reg.rings[t].Load_Acquire();
+      if (!r)
+        continue;
+      fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                    "\"args\":{\"name\":\"%s\"}}",
+              first ? "" : ",\n", t, r->name ? r->name : "thread");
+      first = false;
+
+      unsigned head = r->head.Load_Acquire();
+      unsigned begin = head > RING_EVENTS ? head - RING_EVENTS : 0;
+      for (unsigned i = begin; i < head; ++i) {
+        const event &e = r->events[i % RING_EVENTS];
+        fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                      "\"ts\":%.3f,\"dur\":%.3f}",
+                e.name, t, (e.start - origin) / 1000.0, e.duration / 1000.0);
+      }
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+  }
+
+private:
+  struct ring {
+    const char *name;
+    OVR::AtomicInt<unsigned> head;  /* events written so far */
+    event events[RING_EVENTS];
+  };
+
+  struct registry {
+    registry() : origin(nanos()) {
+      count = 0;
+      for (int i = 0; i < MAX_THREADS; ++i) rings[i] = NULL;
+    }
+    uint64_t origin;                      /* trace time 0 */
+    OVR::AtomicInt<int> count;            /* slots claimed */
+    OVR::AtomicPtr<ring> rings[MAX_THREADS];
+  };
+
+  static void push(ring *r, const char *name, uint64_t start, uint64_t duration) {
+    unsigned head = r->head;  // Only the owning thread writes head.
+    event &e = r->events[head % RING_EVENTS];
+    e.name = name;
+    e.start = start;
+    e.duration = duration;
+    r->head.Store_Release(head + 1);
+  }
+
+  static registry &threads() {
+    static registry reg;
+    return reg;
+  }
+
+  /* This thread's ring, created on first use. NULL if out of slots. */
+  static ring *threadRing() {
+    static __thread ring *mine = NULL;
+    static __thread bool full = false;
+    if (mine || full)
+      return mine;
+
+    int index;
+    mine = claimRing(index);
+    full = (mine == NULL);
+    return mine;
+  }
+
+  /* Claim a registry slot for a new ring. NULL if out of slots. */
+  static ring *claimRing(int &index) {
+    registry &reg = threads();
+    index = reg.count.ExchangeAdd_Sync(1);
+    if (index >= MAX_THREADS) {
+      // Only the first thread past the limit sees index == MAX_THREADS.
+      if (index == MAX_THREADS)
+        fprintf(stderr, "frame_profiler: more than %d threads and tracks, "
+                        "timings of the rest are dropped\n", MAX_THREADS);
+      return NULL;
+    }
+    ring *r = new ring;
+    r->name = NULL;
+    r->head = 0;
+    reg.rings[index].Store_Release(r);
+    return r;
+  }
+};
+
+
+// Records the time from construction to destruction under name.
+class profile_scope {
+public:
+  explicit profile_scope(const char *name_)
+  : name(name_), start(frame_profiler::nanos())
+  {}
+
+  ~profile_scope() {
+    frame_profiler::record(name, start, frame_profiler::nanos() - start);
+  }
+
+private:
+  const char *name;
+  uint64_t start;
+};
+
+#endif //#ifndef FILE_FRAME_PROFILER_H_INCLUDED
@@ -0,0 +1,193 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// gpu_hole_filler.h
+// Fills holes in a raw depth texture on the GPU by push-pull, with the
+// same arithmetic as depth_hole_filler.h on the CPU.
+// There is no associated source file.
+//
+// Before including this file, you must include glew.h (glslprog.h does).
+//
+// Each level of the pyramid is an RG32F texture of (disparity, weight),
+// drawn by one fullscreen pass. The result is an RG32F texture of
+// (disparity, confidence) the size of the depth texture. Texels still in a
+// hole have confidence 0.
+//
+// Usage (GL context current):
+//   filler.create(pull_program, push_program);  // hole_pull_f, hole_push_f
+//   filler.resize(cols, rows);                   // when the depth texture does
+//   every new depth frame: filler.fill(depth_texture);
+//   sample filler.filledTexture()
+//
+// fill() uses texture units 4 to 6, and restores the framebuffer, viewport,
+// program and active texture unit.
+
+#ifndef FILE_GPU_HOLE_FILLER_H_INCLUDED
+#define FILE_GPU_HOLE_FILLER_H_INCLUDED
+
+#include "depth_hole_filler.h"
+
+#include <vector>
+
+class gpu_hole_filler {
+public:
+  gpu_hole_filler()
+  : pull(0), push(0), levels(depth_hole_filler::DEFAULT_LEVELS),
+    framebuffer(0), vao(0)
+  {}
+
+  /* pull_program and push_program are fullscreen_v.glsl linked with
+     hole_pull_f.glsl and hole_push_f.glsl. */
+  void create(GLuint pull_program, GLuint push_program, uint16_t invalid_depth,
+              unsigned levels_ = depth_hole_filler::DEFAULT_LEVELS) {
+    pull = pull_program;
+    push = push_program;
+    levels = levels_;
+    glGenFramebuffers(1, &framebuffer);
+    glGenVertexArrays(1, &vao);  // Fullscreen passes read no vertices.
+
+    for (int i = 0; i < 2; ++i) {
+      GLuint program = i == 0 ? pull : push;
+      glUseProgram(program);
+      glUniform1i(glGetUniformLocation(program, "depth_image"), DEPTH_UNIT);
+      glUniform1i(glGetUniformLocation(program, "finer"), FINER_UNIT);
+      glUniform1i(glGetUniformLocation(program, "coarser"), COARSER_UNIT);
+      glUniform1ui(glGetUniformLocation(program, "invalid_depth"), invalid_depth);
+    }
+    glUniform1f(glGetUniformLocation(push, "fade"), depth_hole_filler::fade());
+    glUseProgram(0);
+    pull_from_depth = glGetUniformLocation(pull, "from_depth");
+    push_from_depth = glGetUniformLocation(push, "from_depth");
+  }
+
+  /* Allocate the pyramid for a w x h depth texture */
+  void resize(unsigned w, unsigned h) {
+    deleteTextures();
+    sizes.clear();
+    for (unsigned k = 0; k <= levels; ++k) {
+      sizes.push_back(w);
+      sizes.push_back(h);
+      w = (w + 1) / 2;
+      h = (h + 1) / 2;
+    }
+    // pulled[0] is never made, the depth texture is level 0.
+    pulled.assign(levels + 1, 0);
+    pushed.assign(levels, 0);
+    for (unsigned k = 1; k <= levels; ++k)
+      pulled[k] = makeLevel(k);
+    for (unsigned k = 0; k < levels; ++k)
+      pushed[k] = makeLevel(k);
+  }
+
+  /* Fill the holes of depth_texture, an R16UI texture of the size given to
+     resize(). */
+  void fill(GLuint depth_texture) {
+    GLint old_framebuffer, old_program, old_unit, old_viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &old_framebuffer);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &old_program);
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &old_unit);
+    glGetIntegerv(GL_VIEWPORT, old_viewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glBindVertexArray(vao);
+    bindTexture(DEPTH_UNIT, depth_texture);
+
+    glUseProgram(pull);
+    for (unsigned k = 1; k <= levels; ++k) {
+      glUniform1i(pull_from_depth, k == 1);
+      bindTexture(FINER_UNIT, pulled[k - 1]);
+      drawLevel(k, pulled[k]);
+    }
+
+    glUseProgram(push);
+    for (unsigned k = levels; k-- > 0; ) {
+      glUniform1i(push_from_depth, k == 0);
+      bindTexture(FINER_UNIT, pulled[k]);
+      bindTexture(COARSER_UNIT, k + 1 == levels ? pulled[levels] : pushed[k + 1]);
+      drawLevel(k, pushed[k]);
+    }
+
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, old_framebuffer);
+    glUseProgram(old_program);
+    glActiveTexture(old_unit);
+    glViewport(old_viewport[0], old_viewport[1], old_viewport[2], old_viewport[3]);
+  }
+
+  /* (disparity, confidence) per texel of the depth texture */
+  GLuint filledTexture() const { return pushed.empty() ? 0 : pushed[0]; }
+
+  void destroy() {
+    deleteTextures();
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteVertexArrays(1, &vao);
+    framebuffer = vao = 0;
+  }
+
+private:
+  static const int DEPTH_UNIT = 4;
+  static const int FINER_UNIT = 5;
+  static const int COARSER_UNIT = 6;
+
+  GLuint makeLevel(unsigned k) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RG32F, sizes[2 * k], sizes[2 * k + 1]);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+  }
+
+  void drawLevel(unsigned k, GLuint target) {
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+    glViewport(0, 0, sizes[2 * k], sizes[2 * k + 1]);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+  }
+
+  static void bindTexture(int unit, GLuint texture) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+  }
+
+  void deleteTextures() {
+    for (size_t k = 0; k < pulled.size(); ++k)
+      glDeleteTextures(1, &pulled[k]);
+    for (size_t k = 0; k < pushed.size(); ++k)
+      glDeleteTextures(1, &pushed[k]);
+    pulled.clear();
+    pushed.clear();
+  }
+
+  GLuint pull, push;                 /* programs */
+  GLint pull_from_depth, push_from_depth;
+  unsigned levels;
+  GLuint framebuffer;
+  GLuint vao;
+  std::vector<unsigned> sizes;       /* w, h of each level */
+  std::vector<GLuint> pulled;        /* levels 1 to levels, pulled */
+  std::vector<GLuint> pushed;        /* levels 0 to levels-1, pushed */
+};
+
+#endif //#ifndef FILE_GPU_HOLE_FILLER_H_INCLUDED
@@ -0,0 +1,178 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// gpu_timer.h
+// Measures how long the GPU spends on sections of a frame.
+// There is no associated source file.
+//
+// Before including this file, you must include glew.h (glslprog.h does).
+//
+// Each section is bracketed by GL_TIMESTAMP queries. Queries from a frame
+// are read FRAMES frames later, when the GPU has long finished them, so
+// reading results never stalls the CPU. If the GPU has fallen further
+// behind than that, the frame is not timed at all rather than waiting.
+//
+// Usage (GL context current):
+//   int mesh = timer.addSection("mesh");   // before create
+//   timer.create();
+//   every frame: timer.beginFrame(); timer.begin(mesh); draw();
+//                timer.end(mesh); timer.endFrame();
+//   timer.millis(mesh)   // latest measured time
+
+#ifndef FILE_GPU_TIMER_H_INCLUDED
+#define FILE_GPU_TIMER_H_INCLUDED
+
+#include <stdint.h>
+#include <vector>
+
+class gpu_timer {
+public:
+  static const int FRAMES = 4;  /* Frames in flight before results are read */
+
+  gpu_timer() : frame(0), timing(false), cpu_minus_gpu(0) {}
+
+  /* Add a section, returns its id. name must outlive the timer. */
+  int addSection(const char *name) {
+    section s;
+    s.name = name;
+    s.millis = -1;
+    s.gpu_start = 0;
+    sections.push_back(s);
+    return sections.size() - 1;
+  }
+
+  /* Allocate queries, after every section is added */
+  void create() {
+    queries.resize(FRAMES * sections.size() * 2);
+    used.assign(FRAMES * sections.size(), false);
+    pending.assign(FRAMES, false);
+    if (!queries.empty())
+      glGenQueries(queries.size(), &queries.front());
+  }
+
+  void destroy() {
+    if (!queries.empty())
+      glDeleteQueries(queries.size(), &queries.front());
+    queries.clear();
+  }
+
+  /* Start timing a frame. Collects the results of the frame that used the
+     same queries FRAMES frames ago, if the GPU has finished it.
+     Returns true if new results were collected. */
+  bool beginFrame() {
+    int f = frame % FRAMES;
+    bool collected = false;
+    timing = !queries.empty();
+    if (timing && pending[f])
+      timing = collected = collect(f);
+    if (timing)
+      for (size_t s = 0; s < sections.size(); ++s)
+        used[f * sections.size() + s] = false;
+    return collected;
+  }
+
+  /* Bracket GPU work of section s. Each section may be timed once a frame. */
+  void begin(int s) {
+    if (timing) {
+      glQueryCounter(query(s, 0), GL_TIMESTAMP);
+      used[(frame % FRAMES) * sections.size() + s] = true;
+    }
+  }
+  void end(int s) {
+    if (timing) glQueryCounter(query(s, 1), GL_TIMESTAMP);
+  }
+
+  void endFrame() {
+    if (!timing)
+      return;  // Queries of this slot are still in flight, keep the slot.
+    pending[frame % FRAMES] = true;
+    ++frame;
+  }
+
+  int sectionCount() const { return sections.size(); }
+  const char *name(int s) const { return sections[s].name; }
+
+  /* Latest GPU time of section s in milliseconds, -1 before the first
+     result or if the section was not timed in the measured frame */
+  double millis(int s) const { return sections[s].millis; }
+
+  /* Start of section s in the measured frame, on the CPU's clock in
+     nanoseconds, for lining GPU work up with CPU timings */
+  uint64_t cpuStart(int s) const { return sections[s].gpu_start + cpu_minus_gpu; }
+
+  /* Offset from GPU to CPU clock. Call now and then, with the CPU's time in
+     nanoseconds taken as close to the call as possible. */
+  void calibrate(uint64_t cpu_nanos) {
+    GLint64 gpu_nanos = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_nanos);
+    cpu_minus_gpu = cpu_nanos - uint64_t(gpu_nanos);
+  }
+
+private:
+  struct section {
+    const char *name;
+    double millis;
+    uint64_t gpu_start;
+  };
+
+  GLuint query(int s, int which) const {
+    return queries[((frame % FRAMES) * sections.size() + s) * 2 + which];
+  }
+
+  /* Read the results of slot f. Returns false if they aren't ready. */
+  bool collect(int f) {
+    size_t n = sections.size();
+    for (size_t s = 0; s < n; ++s) {
+      if (!used[f * n + s])
+        continue;
+      GLint available = 0;
+      glGetQueryObjectiv(queries[(f * n + s) * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+      if (!available)
+        return false;
+    }
+
+    for (size_t s = 0; s < n; ++s) {
+      if (!used[f * n + s]) {
+        sections[s].millis = -1;
+        continue;
+      }
+      GLuint64 begin = 0, end = 0;
+      glGetQueryObjectui64v(queries[(f * n + s) * 2], GL_QUERY_RESULT, &begin);
+      glGetQueryObjectui64v(queries[(f * n + s) * 2 + 1], GL_QUERY_RESULT, &end);
+      sections[s].millis = (end - begin) / 1e6;
+      sections[s].gpu_start = begin;
+    }
+    pending[f] = false;
+    return true;
+  }
+
+  std::vector<section> sections;
+  std::vector<GLuint> queries;  /* [frame slot][section][begin, end] */
+  std::vector<bool> used;       /* [frame slot][section] timed */
+  std::vector<bool> pending;    /* [frame slot] results not read yet */
+  unsigned frame;
+  bool timing;                  /* Timing the current frame */
+  uint64_t cpu_minus_gpu;
+};
+
+#endif //#ifndef FILE_GPU_TIMER_H_INCLUDED
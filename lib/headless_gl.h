@@ -0,0 +1,141 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// headless_gl.h
+// OpenGL context with no window, for rendering offscreen on machines with
+// no display or HMD attached.
+// There is no associated source file.
+// Requires EGL, link with -lEGL.
+//
+// Uses Mesa's surfaceless platform and EGL_KHR_surfaceless_context when
+// available, so nothing but framebuffer objects is ever drawn to. Other
+// drivers get the default display and a 1x1 pbuffer to make current.
+// Everything drawn must go to framebuffer objects either way.
+
+#ifndef FILE_HEADLESS_GL_H_INCLUDED
+#define FILE_HEADLESS_GL_H_INCLUDED
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <string.h>  // For strstr
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+class headless_gl {
+public:
+  headless_gl()
+  : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT), surface(EGL_NO_SURFACE)
+  {}
+
+  ~headless_gl() { destroy(); }
+
+  /* Create a desktop OpenGL context and make it current on this thread.
+     Returns false if there is no EGL implementation that can. */
+  bool create() {
+    display = surfacelessDisplay();
+    if (display == EGL_NO_DISPLAY)
+      display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+      return fail();
+    if (!eglBindAPI(EGL_OPENGL_API))
+      return fail();
+
+    const EGLint config_attribs[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+      EGL_DEPTH_SIZE, 24,
+      EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configs = 0;
+    if (!eglChooseConfig(display, config_attribs, &config, 1, &configs) || configs < 1) {
+      // The surfaceless platform has no pbuffers, take any GL config.
+      const EGLint any_attribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+      if (!eglChooseConfig(display, any_attribs, &config, 1, &configs) || configs < 1)
+        return fail();
+    }
+
+    // Default attributes give a compatibility context, the renderer still
+    // uses fixed function lighting and matrices.
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+    if (context == EGL_NO_CONTEXT)
+      return fail();
+
+    const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (extensions && strstr(extensions, "EGL_KHR_surfaceless_context") &&
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+      return true;
+
+    const EGLint pbuffer_attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    surface = eglCreatePbufferSurface(display, config, pbuffer_attribs);
+    if (surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context))
+      return fail();
+    return true;
+  }
+
+  void destroy() {
+    if (display == EGL_NO_DISPLAY)
+      return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+    if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+    eglTerminate(display);
+    display = EGL_NO_DISPLAY;
+    context = EGL_NO_CONTEXT;
+    surface = EGL_NO_SURFACE;
+  }
+
+  /* True if the context is current without any surface */
+  bool isSurfaceless() const {
+    return context != EGL_NO_CONTEXT && surface == EGL_NO_SURFACE;
+  }
+
+private:
+  /* Mesa's surfaceless platform display, or EGL_NO_DISPLAY */
+  static EGLDisplay surfacelessDisplay() {
+    const char *client = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (!client || !strstr(client, "EGL_MESA_platform_surfaceless"))
+      return EGL_NO_DISPLAY;
+
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!getPlatformDisplay)
+      return EGL_NO_DISPLAY;
+    return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+  }
+
+  bool fail() {
+    destroy();
+    return false;
+  }
+
+  EGLDisplay display;
+  EGLContext context;
+  EGLSurface surface;
+};
+
+#endif //#ifndef FILE_HEADLESS_GL_H_INCLUDED
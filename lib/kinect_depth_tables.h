@@ -0,0 +1,94 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// kinect_depth_tables.h
+// Lookup tables for converting raw Kinect disparities into 3d points.
+// There is no associated source file.
+//
+// The tables are filled once at startup with exactly the same arithmetic
+// kinect_depth_image used to do per pixel, so a table lookup gives the
+// same float as the old tan() evaluation.
+
+#ifndef FILE_KINECT_DEPTH_TABLES_H_INCLUDED
+#define FILE_KINECT_DEPTH_TABLES_H_INCLUDED
+
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+class kinect_depth_tables {
+public:
+  // Number of distinct 11 bit disparity values.
+  static const int DISPARITY_LEVELS = 2048;
+
+  // w, h:          dimensions of depth image
+  // invalid_depth: disparities at or above this value have no depth
+  // fov_degrees:   horizontal field of view of depth camera
+  kinect_depth_tables(int w_, int h_, uint16_t invalid_depth, double fov_degrees = 57.8)
+  : w(w_), h(h_), ray_x(w_), ray_y(h_)
+  {
+    pixelFOV = tan(0.5 * (M_PI / 180.0) * fov_degrees)/(w*0.5);
+
+    for (int disp = 0; disp < DISPARITY_LEVELS; ++disp)
+      meters_table[disp] = (disp >= invalid_depth) ? 0.0f : exactDepth(disp);
+
+    // The ray through pixel (x,y) is (ray_x[x], ray_y[y], 1).
+    for (int x = 0; x < w; ++x) ray_x[x] = (x-w*0.5)*pixelFOV;
+    for (int y = 0; y < h; ++y) ray_y[y] = (h*0.5-y)*pixelFOV;
+  }
+
+  /* Return depth, in meters, for this raw disparity */
+  float meters(uint16_t disp) const {
+    // Disparities are 11 bit, clamp so bad input can never read past the table.
+    return meters_table[disp < DISPARITY_LEVELS ? disp : DISPARITY_LEVELS-1];
+  }
+
+  /* X and Y components of the (non unit) view ray of a pixel, Z is 1 */
+  float rayX(int x) const { return ray_x[x]; }
+  float rayY(int y) const { return ray_y[y]; }
+
+  const float *metersTable() const { return meters_table; }
+  const float *rayXTable() const { return &ray_x.front(); }
+  const float *rayYTable() const { return &ray_y.front(); }
+
+  int width() const { return w; }
+  int height() const { return h; }
+
+  /* Unit-depth field of view offset per X or Y pixel */
+  float pixelFieldOfView() const { return pixelFOV; }
+
+  /* Evaluate the disparity to depth function directly (slow) */
+  static float exactDepth(uint16_t disp) {
+    //From Stephane Magnenat's depth-to-distance conversion function:
+    return 0.1236 * tan(disp / 2842.5 + 1.1863) - 0.037; // (meters)
+  }
+
+private:
+  int w, h;
+  float pixelFOV; /* Unit-depth field of view offset per X or Y pixel */
+  float meters_table[DISPARITY_LEVELS];
+  std::vector<float> ray_x;
+  std::vector<float> ray_y;
+};
+
+#endif //#ifndef FILE_KINECT_DEPTH_TABLES_H_INCLUDED
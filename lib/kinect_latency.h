@@ -0,0 +1,215 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// kinect_latency.h
+// End to end latency of Kinect frames, from capture to the display.
+// There is no associated source file.
+// Requires LibOVR's Kernel/OVR_Observer.h.
+//
+// Every displayed depth frame adds its capture, handoff, render and
+// ovrHmd_EndFrame times. Once a second the spans between them are
+// summarized as percentiles and published to observers. This works the way
+// LibOVR's CAPI::LagStatsCalculator publishes its LatencyStatisticsResults.
+//
+// Capture is when the frame arrived on the host, not when the Kinect
+// exposed it. The timestamp libfreenect passes with a frame counts on the
+// Kinect's own clock, which has no known offset to the host's, so the USB
+// transfer before arrival is not included.
+//
+// Spans go into log-linear histograms (16 buckets per power of two above
+// 32 microseconds, so within about 3%), in the spirit of HdrHistogram. Recording one is a few
+// instructions and never allocates, and rare spikes still show up in p99
+// and max.
+//
+// Observers and the calculator both use LibOVR's allocator, so create
+// them after ovr_Initialize. Not thread safe, use from the render thread.
+
+#ifndef FILE_KINECT_LATENCY_H_INCLUDED
+#define FILE_KINECT_LATENCY_H_INCLUDED
+
+#include "Kernel/OVR_Observer.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// Percentiles of one span over a second, in milliseconds.
+struct latency_percentiles {
+  double p50, p95, p99, max;
+};
+
+// Results published once a second.
+struct kinect_latency_results {
+  double interval_seconds;  /* Time covered by these results */
+  unsigned frames;          /* Depth frames displayed */
+
+  latency_percentiles capture_to_handoff;  /* Depth conversion */
+  latency_percentiles handoff_to_render;   /* Waiting for the renderer */
+  latency_percentiles render_to_photon;    /* Rendering, distortion, vsync */
+  latency_percentiles capture_to_photon;   /* End to end */
+};
+
+typedef OVR::Delegate1<void, kinect_latency_results*> kinect_latency_slot;
+
+
+// Log-linear histogram of microsecond values.
+class latency_histogram {
+public:
+  /* One bucket per value below SUB_COUNT, SUB_COUNT/2 per power of two above */
+  static const int SUB_BITS = 5;
+  static const int SUB_COUNT = 1 << SUB_BITS;
+  static const int MAX_BITS = 40;                   /* Values up to ~12 days */
+  static const int BUCKETS = SUB_COUNT + (MAX_BITS - SUB_BITS) * (SUB_COUNT / 2);
+
+  latency_histogram() { reset(); }
+
+  void reset() {
+    memset(counts, 0, sizeof(counts));
+    total = 0;
+    largest = 0;
+  }
+
+  void add(uint64_t micros) {
+    ++counts[bucket(micros)];
+    ++total;
+    if (micros > largest) largest = micros;
+  }
+
+  unsigned count() const { return total; }
+
+  /* Value below which fraction of the values lie, in microseconds */
+  uint64_t percentile(double fraction) const {
+    if (total == 0)
+      return 0;
+    uint64_t rank = uint64_t(fraction * total);
+    if (rank >= total) rank = total - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+      seen += counts[i];
+      if (seen > rank)
+        return bucketMiddle(i) < largest ? bucketMiddle(i) : largest;
+    }
+    return largest;
+  }
+
+  uint64_t max() const { return largest; }
+
+  /* Percentiles in milliseconds */
+  latency_percentiles summary() const {
+    latency_percentiles p;
+    p.p50 = percentile(0.50) / 1000.0;
+    p.p95 = percentile(0.95) / 1000.0;
+    p.p99 = percentile(0.99) / 1000.0;
+    p.max = largest / 1000.0;
+    return p;
+  }
+
+private:
+  static int bucket(uint64_t v) {
+    if (v < uint64_t(SUB_COUNT))
+      return int(v);
+    int msb = 63 - __builtin_clzll(v);
+    if (msb >= MAX_BITS)
+      return BUCKETS - 1;
+    int shift = msb - (SUB_BITS - 1);
+    int top = int(v >> shift);  // SUB_COUNT/2 .. SUB_COUNT-1
+    return SUB_COUNT + (msb - SUB_BITS) * (SUB_COUNT / 2) + (top - SUB_COUNT / 2);
+  }
+
+  static uint64_t bucketMiddle(int i) {
+    if (i < SUB_COUNT)
+      return i;
+    int msb = (i - SUB_COUNT) / (SUB_COUNT / 2) + SUB_BITS;
+    int shift = msb - (SUB_BITS - 1);
+    uint64_t top = (i - SUB_COUNT) % (SUB_COUNT / 2) + SUB_COUNT / 2;
+    return (top << shift) + (uint64_t(1) << shift) / 2;
+  }
+
+  unsigned counts[BUCKETS];
+  unsigned total;
+  uint64_t largest;
+};
+
+
+class kinect_latency_calculator {
+public:
+  static const uint64_t EPOCH_NANOS = 1000000000ull;  /* Results every second */
+
+  kinect_latency_calculator() : epoch_begin(0), frames(0) {}
+
+  /* Add a displayed depth frame. All times are monotonic nanoseconds:
+     capture:   depth frame arrived from the Kinect, on the host
+     handoff:   vertices published to the renderer
+     render:    renderer started drawing it
+     end_frame: ovrHmd_EndFrame returned with it on screen */
+  void addFrame(uint64_t capture, uint64_t handoff, uint64_t render, uint64_t end_frame) {
+    if (epoch_begin == 0)
+      epoch_begin = capture;
+
+    capture_to_handoff.add(micros(capture, handoff));
+    handoff_to_render.add(micros(handoff, render));
+    render_to_photon.add(micros(render, end_frame));
+    capture_to_photon.add(micros(capture, end_frame));
+    ++frames;
+
+    if (end_frame - epoch_begin >= EPOCH_NANOS)
+      publish(end_frame);
+  }
+
+  void addResultsObserver(OVR::ObserverScope<kinect_latency_slot> *observer) {
+    observer->GetPtr()->Observe(subject);
+  }
+
+private:
+  static uint64_t micros(uint64_t from, uint64_t to) {
+    return to > from ? (to - from) / 1000 : 0;
+  }
+
+  void publish(uint64_t now) {
+    kinect_latency_results results;
+    results.interval_seconds = (now - epoch_begin) / 1e9;
+    results.frames = frames;
+    results.capture_to_handoff = capture_to_handoff.summary();
+    results.handoff_to_render = handoff_to_render.summary();
+    results.render_to_photon = render_to_photon.summary();
+    results.capture_to_photon = capture_to_photon.summary();
+    subject.GetPtr()->Call(&results);
+
+    // Reset for next epoch
+    capture_to_handoff.reset();
+    handoff_to_render.reset();
+    render_to_photon.reset();
+    capture_to_photon.reset();
+    frames = 0;
+    epoch_begin = now;
+  }
+
+  uint64_t epoch_begin;
+  unsigned frames;
+  latency_histogram capture_to_handoff;
+  latency_histogram handoff_to_render;
+  latency_histogram render_to_photon;
+  latency_histogram capture_to_photon;
+  OVR::ObserverScope<kinect_latency_slot> subject;
+};
+
+#endif //#ifndef FILE_KINECT_LATENCY_H_INCLUDED
@@ -0,0 +1,323 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// kinect_recording.h
+// Writing and reading recorded Kinect sessions.
+// There is no associated source file.
+//
+// A recording is laid out to be memory mapped and read in place:
+//
+//   page 0:  header: "KREC", uint32 version, uint16 width, uint16 height,
+//            uint32 0, uint64 index offset, uint64 index entries
+//   each frame, in the order the frames arrived: its kinect_chunk, in the
+//            last bytes before the payload, then the payload, starting on
+//            a page boundary (11 bit depth as uint16 or depth_codec
+//            encoded, or packed rgb)
+//   index:   one kinect_chunk per frame, giving its type, times, payload
+//            offset and size
+//
+// The index is written when the recording is closed. A recording that was
+// never closed, because the program was killed or crashed, has an index
+// offset of 0; its index is rebuilt from the chunk before each payload, up
+// to the last frame that was written completely. Version 2 recordings have
+// no chunk before their payloads, and are only read when closed.
+//
+// Fields are in host byte order, which is little endian everywhere this
+// runs. Unknown chunk types should be skipped, so later versions can add
+// some.
+//
+// Neither class is thread safe. libfreenect delivers depth and video on
+// its one event thread, so a recorder fed from the callbacks needs no lock.
+// Payload pointers from a kinect_archive may be read from any thread while
+// it stays open.
+
+#ifndef FILE_KINECT_RECORDING_H_INCLUDED
+#define FILE_KINECT_RECORDING_H_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>     // For open
+#include <unistd.h>    // For close
+#include <sys/mman.h>  // For mmap
+#include <sys/stat.h>  // For fstat
+#include <string>
+#include <vector>
+
+const uint32_t KINECT_DEPTH_CHUNK = 0x48545044;  // "DPTH"
+const uint32_t KINECT_DEPTH_CODEC_CHUNK = 0x5A545044;  // "DPTZ", see depth_codec.h
+const uint32_t KINECT_VIDEO_CHUNK = 0x20424752;  // "RGB "
+
+// Payloads start on multiples of this, so they can be used straight out of
+// a mapping. 4096 is the page size on every platform this runs on.
+const uint32_t KINECT_RECORDING_ALIGN = 4096;
+
+struct kinect_recording_header {
+  char magic[4];
+  uint32_t version;
+  uint16_t width, height;
+  uint32_t reserved;
+  uint64_t index_offset;  /* File offset of index, 0 if never closed */
+  uint64_t index_count;   /* Number of index entries */
+};
+
+struct kinect_chunk {
+  uint64_t offset;     /* File offset of payload */
+  uint64_t nanos;      /* Host time since recording started */
+  uint32_t type;
+  uint32_t timestamp;  /* Timestamp libfreenect gave the frame */
+  uint32_t bytes;      /* Payload size */
+  uint32_t reserved;
+};
+
+/* Monotonic host time in nanoseconds */
+inline uint64_t kinectRecordingNanos() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+
+class kinect_recorder {
+public:
+  static const uint32_t VERSION = 3;
+
+  kinect_recorder() : file(NULL), start(0), written(0), w(0), h(0) {}
+  ~kinect_recorder() { close(); }
+
+  /* Start a new recording of w x h frames. Returns false on failure. */
+  bool open(const std::string &path, int w_, int h_) {
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (!file)
+      return false;
+    // Frames are large, a big buffer keeps writes to a few syscalls each.
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+    w = w_;
+    h = h_;
+    index.clear();
+    written = 0;
+    start = kinectRecordingNanos();
+
+    // Header is rewritten with the index location on close.
+    return putHeader(0);
+  }
+
+  bool isOpen() const { return file != NULL; }
+
+  /* Append a frame. Returns false if the write failed. */
+  bool write(uint32_t type, uint32_t timestamp, const void *payload, uint32_t bytes) {
+    if (!file)
+      return false;
+    kinect_chunk chunk;
+    chunk.offset = written;
+    chunk.nanos = kinectRecordingNanos() - start;
+    chunk.type = type;
+    chunk.timestamp = timestamp;
+    chunk.bytes = bytes;
+    chunk.reserved = 0;
+
+    // The chunk goes right before the payload, in the padding of the last
+    // page, so a recording that is never closed can be read.
+    uint32_t used = (written + sizeof(chunk)) % KINECT_RECORDING_ALIGN;
+    if (used != 0 && !zeros(KINECT_RECORDING_ALIGN - used))
+      return false;
+    chunk.offset = written + sizeof(chunk);
+    if (!put(&chunk, sizeof(chunk)) || !put(payload, bytes))
+      return false;
+    index.push_back(chunk);
+    return true;
+  }
+
+  /* Write the index and finish the recording */
+  void close() {
+    if (!file)
+      return;
+    // Keep the index's 64 bit fields aligned for reading in place.
+    uint64_t index_offset = (written + 7) / 8 * 8;
+    if (zeros(uint32_t(index_offset - written)) &&
+        (index.empty() || put(&index.front(), index.size() * sizeof(kinect_chunk)))) {
+      fseek(file, 0, SEEK_SET);
+      putHeader(index_offset);
+    }
+    fclose(file);
+    file = NULL;
+  }
+
+  unsigned chunkCount() const { return index.size(); }
+  uint64_t bytesWritten() const { return written; }
+
+private:
+  bool putHeader(uint64_t index_offset) {
+    kinect_recording_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "KREC", 4);
+    header.version = VERSION;
+    header.width = w;
+    header.height = h;
+    header.index_offset = index_offset;
+    header.index_count = index_offset ? index.size() : 0;
+    return put(&header, sizeof(header));
+  }
+
+  bool put(const void *data, size_t bytes) {
+    if (fwrite(data, 1, bytes, file) != bytes)
+      return false;
+    written += bytes;
+    return true;
+  }
+
+  /* Write bytes zeros, less than KINECT_RECORDING_ALIGN */
+  bool zeros(uint32_t bytes) {
+    static const char zero[KINECT_RECORDING_ALIGN] = {0};
+    return put(zero, bytes);
+  }
+
+  FILE *file;
+  uint64_t start;     /* Host time recording started */
+  uint64_t written;   /* Bytes in file so far */
+  int w, h;
+  std::vector<kinect_chunk> index;
+};
+
+
+// Read only view of a whole recording, memory mapped. Payloads are read in
+// place, pages are only loaded as they are touched, so recordings much
+// larger than memory can be played and scrubbed.
+class kinect_archive {
+public:
+  kinect_archive() : base(NULL), length(0), entries(NULL), count(0), w(0), h(0) {}
+  ~kinect_archive() { close(); }
+
+  /* Map a recording. Returns false if it is missing, not a recording, or
+     a version 2 recording that was never closed. */
+  bool open(const std::string &path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(kinect_recording_header)) {
+      length = info.st_size;
+      void *mapped = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+      base = (mapped == MAP_FAILED) ? NULL : static_cast<const uint8_t*>(mapped);
+    }
+    ::close(fd);  // The mapping keeps the file open.
+    if (!base)
+      return false;
+
+    const kinect_recording_header &header =
+      *reinterpret_cast<const kinect_recording_header*>(base);
+    bool closed = header.index_offset != 0 &&
+      header.index_offset + header.index_count * sizeof(kinect_chunk) <= length;
+    if (memcmp(header.magic, "KREC", 4) != 0 ||
+        (header.version != kinect_recorder::VERSION && header.version != 2) ||
+        (header.version == 2 && !closed)) {
+      close();
+      return false;
+    }
+    w = header.width;
+    h = header.height;
+    if (closed) {
+      entries = reinterpret_cast<const kinect_chunk*>(base + header.index_offset);
+      count = header.index_count;
+    } else {
+      rebuildIndex();
+    }
+
+    // Playback mostly reads straight through.
+    madvise(const_cast<uint8_t*>(base), length, MADV_SEQUENTIAL);
+    return true;
+  }
+
+  bool isOpen() const { return base != NULL; }
+  int width() const { return w; }
+  int height() const { return h; }
+
+  /* Number of chunks */
+  size_t size() const { return count; }
+  const kinect_chunk &chunk(size_t i) const { return entries[i]; }
+
+  /* Payload of chunk i, page aligned, valid until close. NULL if the index
+     points outside the file. */
+  const uint8_t *payload(size_t i) const {
+    const kinect_chunk &c = entries[i];
+    return (c.offset + c.bytes <= length) ? base + c.offset : NULL;
+  }
+
+  /* Index of first chunk at or after nanos into the recording */
+  size_t find(uint64_t nanos) const {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (entries[mid].nanos < nanos) lo = mid + 1;
+      else hi = mid;
+    }
+    return lo;
+  }
+
+  /* Length of the recording in nanoseconds */
+  uint64_t duration() const { return count ? entries[count-1].nanos : 0; }
+
+  void close() {
+    if (base)
+      munmap(const_cast<uint8_t*>(base), length);
+    base = NULL;
+    entries = NULL;
+    count = 0;
+    recovered.clear();
+  }
+
+private:
+  /* Collect the chunk before each payload of a recording that was never
+     closed, up to the first one that is missing, torn or truncated. */
+  void rebuildIndex() {
+    recovered.clear();
+    uint64_t payload = KINECT_RECORDING_ALIGN;
+    while (payload <= length) {
+      const kinect_chunk &c =
+        *reinterpret_cast<const kinect_chunk*>(base + payload - sizeof(kinect_chunk));
+      if (c.offset != payload || c.bytes == 0 || c.offset + c.bytes > length ||
+          (!recovered.empty() && c.nanos < recovered.back().nanos))
+        break;
+      recovered.push_back(c);
+
+      // The next chunk ends on the first page boundary after this payload.
+      uint64_t end = payload + c.bytes + sizeof(kinect_chunk);
+      payload = (end + KINECT_RECORDING_ALIGN - 1) / KINECT_RECORDING_ALIGN * KINECT_RECORDING_ALIGN;
+    }
+    entries = recovered.empty() ? NULL : &recovered.front();
+    count = recovered.size();
+  }
+
+  const uint8_t *base;
+  size_t length;
+  const kinect_chunk *entries;
+  size_t count;
+  int w, h;
+  std::vector<kinect_chunk> recovered;  /* Index of a recording never closed */
+};
+
+#endif //#ifndef FILE_KINECT_RECORDING_H_INCLUDED
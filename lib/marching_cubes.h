@@ -0,0 +1,200 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// marching_cubes.h
+// Triangle tables for extracting the zero crossing of a sampled signed
+// distance as triangles, one cube of 8 samples at a time.
+// There is no associated source file.
+//
+// Instead of the usual hand written 256 case table, the tables are built
+// once at startup by walking the faces of the cube: on every face the
+// edges with a sign change are joined into segments, the segments of all
+// six faces chain into closed loops, and each loop is cut into a fan of
+// triangles. Faces with two diagonal inside corners always cut the inside
+// corners off, and neighbouring cubes see the same face the same way, so
+// the surface has no cracks. Triangles wind counter clockwise seen from
+// the outside (positive distance).
+//
+// Corner c of a cube is at (c & 1, c >> 1 & 1, c >> 2 & 1). A case is the
+// bit mask of corners with negative distance.
+
+#ifndef FILE_MARCHING_CUBES_H_INCLUDED
+#define FILE_MARCHING_CUBES_H_INCLUDED
+
+#include <stdint.h>
+#include <vector>
+
+class marching_cubes {
+public:
+  static const int CORNERS = 8;
+  static const int EDGES = 12;
+  static const int CASES = 256;
+
+  marching_cubes() {
+    // Edges join corners that differ in one bit, lower corner first.
+    int e = 0;
+    for (int bit = 1; bit <= 4; bit <<= 1)
+      for (int c = 0; c < CORNERS; ++c)
+        if (!(c & bit)) {
+          edge_corners[e][0] = c;
+          edge_corners[e][1] = c | bit;
+          ++e;
+        }
+
+    for (int cube = 0; cube < CASES; ++cube)
+      buildCase(cube);
+  }
+
+  /* Corner end (0 or 1) of edge; end 0 is the lower corner */
+  int edgeCorner(int edge, int end) const { return edge_corners[edge][end]; }
+
+  /* Number of triangles for a case */
+  unsigned triangleCount(int cube) const { return unsigned(triangles[cube].size() / 3); }
+
+  /* Three edge indices per triangle of a case, each the edge a vertex lies on */
+  const uint8_t *triangleEdges(int cube) const {
+    return triangles[cube].empty() ? NULL : &triangles[cube].front();
+  }
+
+private:
+  int edgeBetween(int a, int b) const {
+    for (int e = 0; e < EDGES; ++e)
+      if ((edge_corners[e][0] == a && edge_corners[e][1] == b) ||
+          (edge_corners[e][0] == b && edge_corners[e][1] == a))
+        return e;
+    return -1;
+  }
+
+  static float cornerAxis(int c, int axis) { return float((c >> axis) & 1); }
+
+  void buildCase(int cube) {
+    // Each crossed edge lies on two faces, so gets two segment ends.
+    int links[EDGES][2];
+    int link_count[EDGES];
+    for (int e = 0; e < EDGES; ++e)
+      link_count[e] = 0;
+
+    for (int axis = 0; axis < 3; ++axis) {
+      int u = 1 << ((axis + 1) % 3), v = 1 << ((axis + 2) % 3);
+      for (int side = 0; side < 2; ++side) {
+        int base = side << axis;
+        int face[4] = {base, base | u, base | u | v, base | v};
+        int edges[4];
+        bool crossed[4];
+        int crossings = 0;
+        for (int k = 0; k < 4; ++k) {
+          int a = face[k], b = face[(k + 1) % 4];
+          edges[k] = edgeBetween(a, b);
+          crossed[k] = inside(cube, a) != inside(cube, b);
+          crossings += crossed[k];
+        }
+
+        if (crossings == 2) {
+          int first = -1;
+          for (int k = 0; k < 4; ++k)
+            if (crossed[k]) {
+              if (first < 0)
+                first = edges[k];
+              else
+                link(links, link_count, first, edges[k]);
+            }
+        } else if (crossings == 4) {
+          // Cut off each inside corner, between its two edges.
+          for (int k = 0; k < 4; ++k)
+            if (inside(cube, face[k]))
+              link(links, link_count, edges[(k + 3) % 4], edges[k]);
+        }
+      }
+    }
+
+    // Follow the links around each loop.
+    bool used[EDGES] = {false};
+    for (int start = 0; start < EDGES; ++start) {
+      if (used[start] || link_count[start] != 2)
+        continue;
+      std::vector<int> loop;
+      int prev = -1, e = start;
+      do {
+        loop.push_back(e);
+        used[e] = true;
+        int next = links[e][0] != prev ? links[e][0] : links[e][1];
+        prev = e;
+        e = next;
+      } while (e != start && !used[e]);
+
+      addLoop(cube, loop);
+    }
+  }
+
+  /* Fan triangulate a loop of crossed edges, wound to face outside */
+  void addLoop(int cube, std::vector<int> &loop) {
+    if (loop.size() < 3)
+      return;
+
+    // Compare the loop's normal, from the midpoints of its edges, with
+    // the direction from inside corners to outside ones.
+    float normal[3] = {0, 0, 0}, outward[3] = {0, 0, 0};
+    for (size_t i = 0; i < loop.size(); ++i) {
+      float a[3], b[3];
+      midpoint(loop[i], a);
+      midpoint(loop[(i + 1) % loop.size()], b);
+      normal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+      normal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+      normal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+
+      int c0 = edge_corners[loop[i]][0], c1 = edge_corners[loop[i]][1];
+      int in = inside(cube, c0) ? c0 : c1, out = in == c0 ? c1 : c0;
+      for (int axis = 0; axis < 3; ++axis)
+        outward[axis] += cornerAxis(out, axis) - cornerAxis(in, axis);
+    }
+    if (normal[0] * outward[0] + normal[1] * outward[1] + normal[2] * outward[2] < 0) {
+      for (size_t i = 0, j = loop.size() - 1; i < j; ++i, --j) {
+        int t = loop[i]; loop[i] = loop[j]; loop[j] = t;
+      }
+    }
+
+    for (size_t i = 1; i + 1 < loop.size(); ++i) {
+      triangles[cube].push_back(uint8_t(loop[0]));
+      triangles[cube].push_back(uint8_t(loop[i]));
+      triangles[cube].push_back(uint8_t(loop[i + 1]));
+    }
+  }
+
+  void midpoint(int edge, float out[3]) const {
+    for (int axis = 0; axis < 3; ++axis)
+      out[axis] = 0.5f * (cornerAxis(edge_corners[edge][0], axis) +
+                          cornerAxis(edge_corners[edge][1], axis));
+  }
+
+  static bool inside(int cube, int corner) { return (cube >> corner) & 1; }
+
+  static void link(int links[EDGES][2], int link_count[EDGES], int a, int b) {
+    links[a][link_count[a]++] = b;
+    links[b][link_count[b]++] = a;
+  }
+
+  int edge_corners[EDGES][2];
+  std::vector<uint8_t> triangles[CASES];
+};
+
+#endif //#ifndef FILE_MARCHING_CUBES_H_INCLUDED
@@ -0,0 +1,179 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// mesh_culling.h
+// Drops the triangles of a Kinect mesh that span a depth discontinuity,
+// on the CPU, so the mesh can be drawn without a geometry shader.
+// There is no associated source file.
+//
+// The mesh is a grid of cols x rows vertices, x,y,z floats row by row, as
+// depth_unprojector writes them. Each grid square is two triangles, the
+// ones a triangle strip over a pair of rows makes:
+//   (x,y) (x,y+1) (x+1,y)   and   (x+1,y) (x,y+1) (x+1,y+1)
+// A triangle is dropped when any of its edges is max_edge or longer,
+// which also drops triangles touching an invalid pixel, since those
+// vertices are at the origin.
+//
+// Both have versions over a band of rows, so bands can be culled on
+// several threads at once.
+//
+// Two ways to drop them:
+//   compactMeshTriangles   writes GL_TRIANGLES indices of only the
+//                          triangles to draw. Exact, but the indices are
+//                          streamed every frame.
+//   markCulledMeshVertices overwrites vertices with NaN, and the GPU
+//                          discards every triangle with a NaN vertex. No
+//                          indices to stream, but it works per vertex, so
+//                          some triangles next to a discontinuity go too.
+
+#ifndef FILE_MESH_CULLING_H_INCLUDED
+#define FILE_MESH_CULLING_H_INCLUDED
+
+#include <stdint.h>
+#include <limits>
+
+/* Most indices compactMeshTriangles writes for a cols x rows grid */
+inline unsigned meshTriangleIndexCapacity(unsigned cols, unsigned rows) {
+  return (cols > 1 && rows > 1) ? 6 * (cols - 1) * (rows - 1) : 0;
+}
+
+/* True if vertices a and b are at least sqrt(max_edge_sq) apart */
+inline bool meshLongEdge(const float *a, const float *b, float max_edge_sq) {
+  float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+  return dx*dx + dy*dy + dz*dz >= max_edge_sq;
+}
+
+/* Write indices of the triangles of grid square rows [row_begin, row_end)
+   with no edge max_edge or longer into indices, which must have room for
+   6 * (cols - 1) indices per square row. Square row y is between vertex
+   rows y and y+1. Returns the number of indices written. */
+inline unsigned compactMeshTriangleRows(const float *xyz, unsigned cols,
+                                        unsigned row_begin, unsigned row_end,
+                                        float max_edge, uint32_t *indices) {
+  const float max_edge_sq = max_edge * max_edge;
+  uint32_t *out = indices;
+
+  for (unsigned y = row_begin; y < row_end; ++y) {
+    uint32_t top = y * cols;
+    uint32_t bottom = top + cols;
+
+    // Edges shared by neighbouring triangles are tested once: the
+    // vertical edge on the left of each square comes from the last one.
+    bool left_long = meshLongEdge(xyz + 3*top, xyz + 3*bottom, max_edge_sq);
+    for (unsigned x = 0; x + 1 < cols; ++x, ++top, ++bottom) {
+      const float *a0 = xyz + 3*top, *a1 = a0 + 3;
+      const float *b0 = xyz + 3*bottom, *b1 = b0 + 3;
+
+      bool diagonal_long = meshLongEdge(a1, b0, max_edge_sq);
+      bool right_long = meshLongEdge(a1, b1, max_edge_sq);
+
+      if (!left_long && !diagonal_long && !meshLongEdge(a0, a1, max_edge_sq)) {
+        out[0] = top; out[1] = bottom; out[2] = top + 1;
+        out += 3;
+      }
+      if (!right_long && !diagonal_long && !meshLongEdge(b0, b1, max_edge_sq)) {
+        out[0] = top + 1; out[1] = bottom; out[2] = bottom + 1;
+        out += 3;
+      }
+      left_long = right_long;
+    }
+  }
+  return unsigned(out - indices);
+}
+
+/* Write indices of the triangles with no edge max_edge or longer into
+   indices, which must have room for meshTriangleIndexCapacity. Returns the number
+   of indices written. */
+inline unsigned compactMeshTriangles(const float *xyz, unsigned cols, unsigned rows,
+                                 float max_edge, uint32_t *indices) {
+  return rows > 1 ? compactMeshTriangleRows(xyz, cols, 0, rows - 1, max_edge, indices) : 0;
+}
+
+/* True if vertex (x,y) has no depth, or has an edge max_edge or longer to
+   its right, lower or lower left neighbour. */
+inline bool meshVertexCulled(const float *xyz, unsigned cols, unsigned rows,
+                             unsigned x, unsigned y, float max_edge_sq) {
+  const float *v = xyz + 3 * (y * cols + x);
+  if (!(v[2] > 0))
+    return true;
+  if (x + 1 < cols && meshLongEdge(v, v + 3, max_edge_sq))
+    return true;
+  return y + 1 < rows &&
+         (meshLongEdge(v, v + 3*cols, max_edge_sq) ||
+          (x > 0 && meshLongEdge(v, v + 3*(cols - 1), max_edge_sq)));
+}
+
+/* Overwrite with NaN every vertex that has no depth, or has an edge
+   max_edge or longer to its right, lower or lower left neighbour. Every
+   long edge of the mesh has one of these as an end, so every triangle
+   compactMeshTriangles drops has a NaN vertex. Returns vertices marked. */
+inline unsigned markCulledMeshVertices(float *xyz, unsigned cols, unsigned rows,
+                                   float max_edge) {
+  const float max_edge_sq = max_edge * max_edge;
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  unsigned marked = 0;
+
+  // A vertex is only compared with vertices after it, so marking it in
+  // place never affects the tests of the ones still to come.
+  for (unsigned y = 0; y < rows; ++y) {
+    for (unsigned x = 0; x < cols; ++x) {
+      if (meshVertexCulled(xyz, cols, rows, x, y, max_edge_sq)) {
+        float *v = xyz + 3 * (y * cols + x);
+        v[0] = v[1] = v[2] = nan;
+        ++marked;
+      }
+    }
+  }
+  return marked;
+}
+
+/* markCulledMeshVertices in two passes over bands of vertex rows. Marking
+   a band in place would change the vertices the band above compares with,
+   so every band is flagged, into culled with one byte per vertex, before
+   any is marked. Bands may be flagged at once, then marked at once. */
+inline void flagCulledMeshRows(const float *xyz, unsigned cols, unsigned rows,
+                               unsigned row_begin, unsigned row_end,
+                               float max_edge, uint8_t *culled) {
+  const float max_edge_sq = max_edge * max_edge;
+  for (unsigned y = row_begin; y < row_end; ++y)
+    for (unsigned x = 0; x < cols; ++x)
+      culled[y * cols + x] = meshVertexCulled(xyz, cols, rows, x, y, max_edge_sq);
+}
+
+/* Overwrite with NaN the vertices of rows [row_begin, row_end) flagged by
+   flagCulledMeshRows. Returns vertices marked. */
+inline unsigned markCulledMeshRows(float *xyz, unsigned cols,
+                                   unsigned row_begin, unsigned row_end,
+                                   const uint8_t *culled) {
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  unsigned marked = 0;
+  for (unsigned i = row_begin * cols; i < row_end * cols; ++i) {
+    if (culled[i]) {
+      xyz[3*i] = xyz[3*i + 1] = xyz[3*i + 2] = nan;
+      ++marked;
+    }
+  }
+  return marked;
+}
+
+#endif //#ifndef FILE_MESH_CULLING_H_INCLUDED
@@ -0,0 +1,271 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// parallel_for.h
+// Runs a task over a range of indices on a fixed set of helper threads and
+// the calling thread, returning once every index is done.
+// There is no associated source file.
+// Requires LibOVR's Kernel/OVR_Atomic.h and pthreads.
+//
+// The range is cut into chunks of grain indices, and every thread starts
+// with an equal, contiguous share of them, so a thread keeps working on the
+// same rows of an image from one run to the next. A thread that runs out
+// steals the back half of another thread's remaining chunks, so threads
+// that get cheap chunks take more of them. Claiming and stealing are one
+// compare and swap each. Several threads may call run, they take turns.
+//
+// A named run records each thread's share of it with frame_profiler, so
+// stages split over the pool show up per thread in the frame trace.
+//
+// Usage:
+//   class scale : public parallel_task {
+//     void run(unsigned begin, unsigned end) { ... }
+//   };
+//   parallel_for pool(cores - 1);
+//   pool.run(task, count, 16, "scaling");
+
+#ifndef FILE_PARALLEL_FOR_H_INCLUDED
+#define FILE_PARALLEL_FOR_H_INCLUDED
+
+#include "Kernel/OVR_Atomic.h"
+#include "frame_profiler.h"
+
+#include <pthread.h>
+#include <vector>
+
+// Work on a range of indices. run may be called on several threads at
+// once, with ranges that don't overlap.
+class parallel_task {
+public:
+  virtual ~parallel_task() {}
+  virtual void run(unsigned begin, unsigned end) = 0;
+};
+
+class parallel_for {
+public:
+  // helpers: threads besides the caller, 0 runs everything on the caller
+  explicit parallel_for(int helpers)
+  : task(NULL), count(0), grain(1), name(NULL), busy(0), generation(0),
+    stopping(false), shares(new OVR::AtomicInt<unsigned>[helpers + 1]),
+    starts(helpers + 1)
+  {
+    for (int i = 0; i <= helpers; ++i)
+      shares[i] = 0;
+    pthread_mutex_init(&lock, NULL);
+    pthread_mutex_init(&run_lock, NULL);
+    pthread_cond_init(&started, NULL);
+    pthread_cond_init(&finished, NULL);
+    for (int i = 0; i < helpers; ++i) {
+      starts[i + 1].pool = this;
+      starts[i + 1].share = i + 1;
+      pthread_t thread;
+      if (pthread_create(&thread, NULL, &parallel_for::threadFunc, &starts[i + 1]) == 0)
+        threads.push_back(thread);
+    }
+  }
+
+  ~parallel_for() {
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_broadcast(&started);
+    pthread_mutex_unlock(&lock);
+    for (size_t i = 0; i < threads.size(); ++i)
+      pthread_join(threads[i], NULL);
+
+    pthread_cond_destroy(&finished);
+    pthread_cond_destroy(&started);
+    pthread_mutex_destroy(&run_lock);
+    pthread_mutex_destroy(&lock);
+    delete[] shares;
+  }
+
+  /* Threads that run tasks, counting the caller */
+  int threadCount() const { return int(threads.size()) + 1; }
+
+  /* Run t over [0, count_) in chunks of grain_ indices. Blocks until done.
+     If name_ is not NULL, each thread's part is recorded under it. */
+  void run(parallel_task &t, unsigned count_, unsigned grain_, const char *name_ = NULL) {
+    if (count_ == 0)
+      return;
+    if (grain_ == 0)
+      grain_ = 1;
+    // Chunk numbers must fit in half of a share.
+    if (count_ / grain_ >= MAX_CHUNKS)
+      grain_ = count_ / MAX_CHUNKS + 1;
+    if (threads.empty() || count_ <= grain_) {
+      uint64_t start = frame_profiler::nanos();
+      t.run(0, count_);
+      if (name_)
+        frame_profiler::record(name_, start, frame_profiler::nanos() - start);
+      return;
+    }
+
+    pthread_mutex_lock(&run_lock);
+
+    // Helpers are all waiting, nothing touches the shares.
+    unsigned chunks = (count_ + grain_ - 1) / grain_;
+    unsigned threads_ = threadCount();
+    for (unsigned i = 0; i < threads_; ++i)
+      shares[i] = pack(chunks * i / threads_, chunks * (i + 1) / threads_);
+
+    pthread_mutex_lock(&lock);
+    task = &t;
+    count = count_;
+    grain = grain_;
+    name = name_;
+    generation += 1;
+    pthread_cond_broadcast(&started);
+    pthread_mutex_unlock(&lock);
+
+    work(t, 0, count_, grain_, name_);
+
+    // Helpers still on a chunk finish it before the task may go away.
+    pthread_mutex_lock(&lock);
+    while (busy > 0)
+      pthread_cond_wait(&finished, &lock);
+    task = NULL;
+    pthread_mutex_unlock(&lock);
+    pthread_mutex_unlock(&run_lock);
+  }
+
+private:
+  static const unsigned MAX_CHUNKS = 0xffff;
+
+  // A share is the chunks [begin, end) a thread has left, packed in one
+  // atomic word so the owner and thieves can claim from it with a compare
+  // and swap. Chunks are never given back, so a share never returns to a
+  // value a stale compare and swap could expect.
+  static unsigned pack(unsigned begin, unsigned end) { return (begin << 16) | end; }
+  static unsigned shareBegin(unsigned share) { return share >> 16; }
+  static unsigned shareEnd(unsigned share) { return share & 0xffff; }
+
+  struct start {
+    parallel_for *pool;
+    unsigned share;  /* index of the helper's share */
+  };
+
+  static void *threadFunc(void *arg) {
+    start *s = static_cast<start*>(arg);
+    frame_profiler::nameThread("pool helper");
+    s->pool->helper(s->share);
+    return NULL;
+  }
+
+  /* Claim the first chunk of a share. Returns false if it is empty. */
+  bool claim(unsigned index, unsigned &chunk) {
+    for (;;) {
+      unsigned share = shares[index].Load_Acquire();
+      unsigned begin = shareBegin(share), end = shareEnd(share);
+      if (begin >= end)
+        return false;
+      if (shares[index].CompareAndSet_Sync(share, pack(begin + 1, end))) {
+        chunk = begin;
+        return true;
+      }
+    }
+  }
+
+  /* Move the back half of another thread's chunks into share index.
+     Returns false if every other share is empty. */
+  bool steal(unsigned index) {
+    unsigned threads_ = threadCount();
+    for (unsigned i = 1; i < threads_; ++i) {
+      unsigned victim = (index + i) % threads_;
+      for (;;) {
+        unsigned share = shares[victim].Load_Acquire();
+        unsigned begin = shareBegin(share), end = shareEnd(share);
+        if (begin >= end)
+          break;
+        unsigned middle = end - (end - begin + 1) / 2;
+        if (shares[victim].CompareAndSet_Sync(share, pack(begin, middle))) {
+          shares[index].Store_Release(pack(middle, end));
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  /* Run chunks of this thread's share, then stolen ones, until there are
+     none left */
+  void work(parallel_task &t, unsigned index, unsigned count_, unsigned grain_,
+            const char *name_) {
+    uint64_t start_nanos = frame_profiler::nanos();
+    bool worked = false;
+    for (;;) {
+      unsigned chunk;
+      if (!claim(index, chunk)) {
+        if (!steal(index))
+          break;
+        continue;
+      }
+      unsigned begin = chunk * grain_;
+      unsigned end = begin + grain_ < count_ ? begin + grain_ : count_;
+      t.run(begin, end);
+      worked = true;
+    }
+    if (name_ && worked)
+      frame_profiler::record(name_, start_nanos, frame_profiler::nanos() - start_nanos);
+  }
+
+  void helper(unsigned index) {
+    unsigned seen = 0;
+    pthread_mutex_lock(&lock);
+    for (;;) {
+      while (!stopping && (generation == seen || !task))
+        pthread_cond_wait(&started, &lock);
+      if (stopping)
+        break;
+      seen = generation;
+      parallel_task *t = task;
+      unsigned count_ = count, grain_ = grain;
+      const char *name_ = name;
+      busy += 1;
+      pthread_mutex_unlock(&lock);
+
+      work(*t, index, count_, grain_, name_);
+
+      pthread_mutex_lock(&lock);
+      busy -= 1;
+      if (busy == 0)
+        pthread_cond_broadcast(&finished);
+    }
+    pthread_mutex_unlock(&lock);
+  }
+
+  std::vector<pthread_t> threads;
+  parallel_task *task;          /* under lock, NULL between runs */
+  unsigned count, grain;        /* under lock */
+  const char *name;             /* under lock */
+  unsigned busy;                /* helpers working on the task */
+  unsigned generation;          /* runs started */
+  bool stopping;
+  OVR::AtomicInt<unsigned> *shares;  /* chunks left per thread, caller's first */
+  std::vector<start> starts;    /* arguments of helper threads */
+  pthread_mutex_t lock;
+  pthread_mutex_t run_lock;     /* one run at a time */
+  pthread_cond_t started;       /* a run started, or stopping */
+  pthread_cond_t finished;      /* busy went to 0 */
+};
+
+#endif //#ifndef FILE_PARALLEL_FOR_H_INCLUDED
@@ -0,0 +1,91 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// synthetic_kinect.h
+// Made up Kinect frames, for benchmarking without a Kinect or a recording.
+// There is no associated source file.
+
+#ifndef FILE_SYNTHETIC_KINECT_H_INCLUDED
+#define FILE_SYNTHETIC_KINECT_H_INCLUDED
+
+#include <stdint.h>
+#include <vector>
+
+// Fill frame with a synthetic w x h, 11 bit disparity image roughly like a
+// room seen by the Kinect: a sloped back wall, a blob standing in front of
+// it that moves with frame_index, an invalid shadow to the blob's right,
+// and a little sensor noise. Invalid pixels are set to invalid_depth.
+inline void makeSyntheticDepthFrame(std::vector<uint16_t> &frame, int w, int h,
+                                    uint16_t invalid_depth, unsigned frame_index)
+{
+    frame.resize(w * h);
+
+    uint32_t noise = 2463534242u + frame_index;
+    int blob_x = w / 4 + int(frame_index * 7 % (w / 2));
+    int blob_y = h / 2;
+    int radius = h * 3 / 16;
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            // xorshift32
+            noise ^= noise << 13;
+            noise ^= noise >> 17;
+            noise ^= noise << 5;
+
+            int dx = x - blob_x;
+            int dy = y - blob_y;
+            uint16_t disp;
+            if (dx*dx + dy*dy < radius*radius)
+                disp = 700 + (dx*dx + dy*dy) / 200;
+            else if (dx > 0 && dx < radius + 12 && dy*dy < radius*radius)
+                disp = invalid_depth;
+            else
+                disp = 900 + y / 8;
+
+            if (disp != invalid_depth)
+                disp += noise % 3;
+            if (noise % 97 == 0)
+                disp = invalid_depth;
+
+            frame[y*w + x] = disp;
+        }
+    }
+}
+
+// Fill frame with a w x h rgb checkerboard, so textured geometry has
+// something to sample.
+inline void makeSyntheticVideoFrame(std::vector<uint8_t> &frame, int w, int h)
+{
+    frame.resize(w * h * 3);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            uint8_t *pixel = &frame[(y*w + x) * 3];
+            bool light = ((x / 32) + (y / 32)) % 2 == 0;
+            pixel[0] = light ? 200 : 60;
+            pixel[1] = uint8_t(x * 255 / w);
+            pixel[2] = uint8_t(y * 255 / h);
+        }
+    }
+}
+
+#endif //#ifndef FILE_SYNTHETIC_KINECT_H_INCLUDED
@@ -0,0 +1,170 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// texture_stream.h
+// Texture that a capture thread's frames are streamed into through pixel
+// buffer objects.
+// There is no associated source file.
+// Requires GLEW and LibOVR's Kernel/OVR_Timer.h.
+//
+// Before including this file, you must include glew.h (glslprog.h does).
+//
+// Texture storage is allocated once with glTexStorage2D. Each new frame is
+// copied into the next of a ring of PBOs, and glTexSubImage2D sources the
+// PBO, so the transfer to the texture runs on the GPU alongside rendering
+// instead of stalling the render thread. A PBO is not written again until
+// the fence after its transfer has passed.
+//
+// All calls need the GL context current.
+
+#ifndef FILE_TEXTURE_STREAM_H_INCLUDED
+#define FILE_TEXTURE_STREAM_H_INCLUDED
+
+#include "Kernel/OVR_Timer.h"
+
+#include <stdint.h>
+#include <string.h>  // For memcpy
+
+class texture_stream {
+public:
+  static const int BUFFERS = 3;
+
+  texture_stream()
+  : texture(0), width(0), height(0), format(0), frame_bytes(0), next(0),
+    uploads(0), upload_seconds(0), stalls(0)
+  {
+    for (int i = 0; i < BUFFERS; ++i) {
+      buffers[i] = 0;
+      fences[i] = 0;
+    }
+  }
+
+  /* Create a w x h texture with internal_format storage, fed frames of
+     external_format GL_UNSIGNED_BYTE pixels with bytes_per_pixel each */
+  void create(int w, int h, GLenum internal_format, GLenum external_format,
+              int bytes_per_pixel) {
+    width = w;
+    height = h;
+    format = external_format;
+    frame_bytes = GLsizeiptr(w) * h * bytes_per_pixel;
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexStorage2D(GL_TEXTURE_2D, 1, internal_format, w, h);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenBuffers(BUFFERS, buffers);
+    for (int i = 0; i < BUFFERS; ++i) {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[i]);
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, frame_bytes, NULL, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+
+  void destroy() {
+    for (int i = 0; i < BUFFERS; ++i) {
+      if (fences[i]) glDeleteSync(fences[i]);
+      fences[i] = 0;
+    }
+    glDeleteBuffers(BUFFERS, buffers);
+    glDeleteTextures(1, &texture);
+    texture = 0;
+  }
+
+  GLuint textureId() const { return texture; }
+
+  /* Copy a new frame into the texture, reads frame_bytes from pixels.
+     Leaves the texture bound to the active texture unit. */
+  void upload(const void *pixels) {
+    double start = OVR::Timer::GetSeconds();
+
+    // Wait for the GPU to finish with this PBO from BUFFERS frames ago.
+    // That should already have happened, count it when it hasn't.
+    if (fences[next]) {
+      GLenum status = glClientWaitSync(fences[next], 0, 0);
+      if (status == GL_TIMEOUT_EXPIRED) {
+        ++stalls;
+        glClientWaitSync(fences[next], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+      }
+      glDeleteSync(fences[next]);
+      fences[next] = 0;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[next]);
+    void *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frame_bytes,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT |
+                                 GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dst) {
+      memcpy(dst, pixels, frame_bytes);
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    } else {
+      glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, frame_bytes, pixels);
+    }
+
+    // Source is the bound PBO, starting at offset 0.
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                    format, GL_UNSIGNED_BYTE, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    fences[next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    next = (next + 1) % BUFFERS;
+
+    ++uploads;
+    upload_seconds += OVR::Timer::GetSeconds() - start;
+  }
+
+  // *** Counters
+
+  /* Frames uploaded */
+  unsigned uploadCount() const { return uploads; }
+  /* Render thread time spent in upload() */
+  double uploadSeconds() const { return upload_seconds; }
+  /* Average render thread time per upload, in milliseconds */
+  double averageUploadMillis() const {
+    return uploads ? 1000.0 * upload_seconds / uploads : 0;
+  }
+  /* Uploads that had to wait for the GPU to release a PBO */
+  unsigned stallCount() const { return stalls; }
+  /* Bytes of pixels uploaded */
+  uint64_t uploadBytes() const { return uint64_t(uploads) * frame_bytes; }
+
+private:
+  GLuint texture;
+  int width, height;
+  GLenum format;            /* external format of frames */
+  GLsizeiptr frame_bytes;
+  GLuint buffers[BUFFERS];  /* PBO ring */
+  GLsync fences[BUFFERS];   /* signaled when GPU has read PBO */
+  int next;                 /* PBO the next frame goes into */
+
+  unsigned uploads;
+  double upload_seconds;
+  unsigned stalls;
+};
+
+#endif //#ifndef FILE_TEXTURE_STREAM_H_INCLUDED
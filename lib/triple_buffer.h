@@ -0,0 +1,93 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// triple_buffer.h
+// Wait free hand off of the latest frame from one producer thread to one
+// consumer thread.
+// There is no associated source file.
+// Requires LibOVR's Kernel/OVR_Atomic.h.
+//
+// There are three slots. The producer always owns one (back), the
+// consumer always owns one (front), and the third (middle) holds the most
+// recently published frame. Publishing and taking a frame are a single
+// atomic exchange of slot indices, so neither side ever waits for the
+// other and nothing is copied or allocated. Frames the consumer did not
+// get to before the next publish are dropped.
+//
+// Usage:
+//   producer:  fill(buffer.back());  buffer.publish();
+//   consumer:  if (buffer.update()) use(buffer.front());
+
+#ifndef FILE_TRIPLE_BUFFER_H_INCLUDED
+#define FILE_TRIPLE_BUFFER_H_INCLUDED
+
+#include "Kernel/OVR_Atomic.h"
+
+template<class T>
+class triple_buffer {
+public:
+  triple_buffer()
+  : back_index(0), front_index(1), middle(2)
+  {}
+
+  /* Slot i, for setting up storage before the buffer is shared */
+  T &slot(int i) { return slots[i]; }
+
+  // *** Producer
+
+  /* Slot the producer may write into */
+  T &back() { return slots[back_index]; }
+
+  /* Make the back slot the latest frame, and get a new back slot */
+  void publish() {
+    back_index = middle.Exchange_Sync(back_index | FRESH) & INDEX_MASK;
+  }
+
+  // *** Consumer
+
+  /* Take the latest frame if one was published since the last update.
+     Returns true if front() changed. */
+  bool update() {
+    if (!(middle.Load_Acquire() & FRESH))
+      return false;
+
+    front_index = middle.Exchange_Sync(front_index) & INDEX_MASK;
+    return true;
+  }
+
+  /* Slot the consumer may read, valid until the next update() */
+  T &front() { return slots[front_index]; }
+  const T &front() const { return slots[front_index]; }
+
+private:
+  // Set in middle when it holds a frame the consumer has not taken yet.
+  static const int FRESH = 4;
+  static const int INDEX_MASK = 3;
+
+  T slots[3];
+  int back_index;               /* only touched by producer */
+  int front_index;              /* only touched by consumer */
+  OVR::AtomicInt<int> middle;   /* index of middle slot | FRESH */
+};
+
+#endif //#ifndef FILE_TRIPLE_BUFFER_H_INCLUDED
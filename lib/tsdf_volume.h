@@ -0,0 +1,442 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// tsdf_volume.h
+// Fuses Kinect depth frames into a truncated signed distance voxel grid,
+// and extracts the surface as triangles with marching cubes.
+// There is no associated source file.
+// Requires LibOVR's Kernel/OVR_Atomic.h and pthreads, for parallel_for.
+//
+// The grid is in the Kinect's coordinates, so the Kinect must not move.
+// Voxels are stored in BLOCK^3 blocks, allocated only near surfaces the
+// Kinect has seen and found through a hash table of block coordinates.
+// Each voxel keeps a running average of the distance to the surface along
+// the Kinect's view ray, truncated to +-truncation, weighted by how often
+// it was seen up to MAX_WEIGHT frames. Surfaces stay after they drop out
+// of view, and what moves fades in and out over about MAX_WEIGHT frames.
+//
+// Integration and extraction split their blocks over a parallel_for.
+// Only blocks whose voxels moved more than a little, and the neighbours
+// sharing their cubes, are meshed again; every block keeps its triangles.
+//
+// Usage:
+//   tsdf_volume volume(tables, INVALID_DEPTH);
+//   volume.integrate(depth, &pool);
+//   if (volume.extract(&pool)) volume.appendMesh(vertices);
+
+#ifndef FILE_TSDF_VOLUME_H_INCLUDED
+#define FILE_TSDF_VOLUME_H_INCLUDED
+
+#include "kinect_depth_tables.h"
+#include "marching_cubes.h"
+#include "parallel_for.h"
+
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+class tsdf_volume {
+public:
+  static const int BLOCK = 8;                        /* Voxels along a block side */
+  static const int BLOCK_VOXELS = BLOCK * BLOCK * BLOCK;
+  static const int FLOATS_PER_VERTEX = 6;            /* x,y,z, normal x,y,z */
+  static const unsigned MAX_WEIGHT = 32;             /* Frames a voxel's average spans */
+  static const unsigned MIN_WEIGHT = 3;              /* Frames seen before it is meshed */
+  static const unsigned DEFAULT_MAX_BLOCKS = 16384;  /* 32 MiB of voxels */
+
+  // tables:     the depth camera's disparity and view ray tables
+  // invalid:    disparities at or above this have no depth
+  // voxel_size: voxel edge in meters
+  // max_blocks: blocks allocated at most, after that new surfaces are ignored
+  tsdf_volume(const kinect_depth_tables &tables_, uint16_t invalid,
+              float voxel_size = .02f, unsigned max_blocks = DEFAULT_MAX_BLOCKS)
+  : tables(tables_), invalid_depth(invalid), voxel(voxel_size),
+    truncation(4 * voxel_size), block_limit(max_blocks)
+  {
+    unsigned capacity = 1;
+    while (capacity < 2 * max_blocks)
+      capacity <<= 1;
+    table.assign(capacity, -1);
+    blocks.reserve(max_blocks);
+  }
+
+  ~tsdf_volume() {
+    for (size_t i = 0; i < blocks.size(); ++i)
+      delete blocks[i];
+  }
+
+  /* Forget everything fused so far */
+  void reset() {
+    for (size_t i = 0; i < blocks.size(); ++i)
+      delete blocks[i];
+    blocks.clear();
+    table.assign(table.size(), -1);
+  }
+
+  /* Fuse a depth frame, the size of the depth tables. pool may be NULL. */
+  void integrate(const uint16_t *depth, parallel_for *pool) {
+    allocate(depth);
+
+    integrate_task task(*this, depth);
+    if (pool)
+      pool->run(task, unsigned(blocks.size()), 8, "integration band");
+    else
+      task.run(0, unsigned(blocks.size()));
+  }
+
+  /* Mesh the blocks that changed since they were last meshed.
+     Returns true if any block's triangles changed. pool may be NULL. */
+  bool extract(parallel_for *pool) {
+    // A block's cubes reach into the blocks after it in x, y and z, so
+    // those before it mesh again too.
+    remesh.clear();
+    for (size_t i = 0; i < blocks.size(); ++i)
+      blocks[i]->queued = false;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      block &b = *blocks[i];
+      if (!b.changed)
+        continue;
+      b.changed = false;
+      for (int n = 0; n < 8; ++n) {
+        int index = find(b.x - (n & 1), b.y - (n >> 1 & 1), b.z - (n >> 2 & 1));
+        if (index >= 0 && !blocks[index]->queued) {
+          blocks[index]->queued = true;
+          remesh.push_back(index);
+        }
+      }
+    }
+
+    extract_task task(*this);
+    if (pool)
+      pool->run(task, unsigned(remesh.size()), 4, "marching cubes band");
+    else
+      task.run(0, unsigned(remesh.size()));
+    return !remesh.empty();
+  }
+
+  /* Append every block's triangles to out, FLOATS_PER_VERTEX floats per
+     vertex and three vertices per triangle. */
+  void appendMesh(std::vector<float> &out) const {
+    size_t floats = out.size();
+    for (size_t i = 0; i < blocks.size(); ++i)
+      floats += blocks[i]->mesh.size();
+    out.reserve(floats);
+    for (size_t i = 0; i < blocks.size(); ++i)
+      out.insert(out.end(), blocks[i]->mesh.begin(), blocks[i]->mesh.end());
+  }
+
+  unsigned blockCount() const { return unsigned(blocks.size()); }
+  bool isFull() const { return blocks.size() >= block_limit; }
+  float voxelSize() const { return voxel; }
+
+  /* Number of blocks meshed by the last extract */
+  unsigned remeshedCount() const { return unsigned(remesh.size()); }
+
+private:
+  struct voxel_data {
+    int16_t sdf;      /* distance / truncation, scaled to +-SDF_SCALE */
+    uint16_t weight;  /* frames averaged, 0 if never seen */
+  };
+
+  struct block {
+    int x, y, z;         /* block coordinates, BLOCK voxels per unit */
+    bool changed;        /* voxels moved since last meshed */
+    bool queued;         /* in remesh, extract only */
+    voxel_data voxels[BLOCK_VOXELS];  /* x fastest, then y, then z */
+    std::vector<float> mesh;
+  };
+
+  static const int SDF_SCALE = 32767;
+  // A voxel moving this much (in SDF_SCALE units) gets its block meshed
+  // again. Sensor noise on a steady surface stays below it.
+  static const int REMESH_STEP = SDF_SCALE / 64;
+  // Allocate blocks for every ALLOCATE_STRIDE-th pixel and row.
+  static const int ALLOCATE_STRIDE = 4;
+
+  // Cubes whose distance jumps by more than this (in truncations) along
+  // an edge straddle a depth discontinuity, not a surface.
+  static float maxEdgeStep() { return 0.75f; }
+
+  /* Integer floor of a / b for positive b */
+  static int floorDiv(float a, float b) { return int(floorf(a / b)); }
+
+  static unsigned hash(int x, int y, int z) {
+    return unsigned(x) * 73856093u ^ unsigned(y) * 19349669u ^ unsigned(z) * 83492791u;
+  }
+
+  /* Index of block (x,y,z) in blocks, -1 if it was never allocated */
+  int find(int x, int y, int z) const {
+    unsigned mask = unsigned(table.size()) - 1;
+    for (unsigned slot = hash(x, y, z) & mask; ; slot = (slot + 1) & mask) {
+      int index = table[slot];
+      if (index < 0)
+        return -1;
+      const block &b = *blocks[index];
+      if (b.x == x && b.y == y && b.z == z)
+        return index;
+    }
+  }
+
+  /* Index of block (x,y,z), allocating it if there is room. -1 if not. */
+  int findOrAllocate(int x, int y, int z) {
+    unsigned mask = unsigned(table.size()) - 1;
+    unsigned slot = hash(x, y, z) & mask;
+    for (; table[slot] >= 0; slot = (slot + 1) & mask) {
+      const block &b = *blocks[table[slot]];
+      if (b.x == x && b.y == y && b.z == z)
+        return table[slot];
+    }
+    if (blocks.size() >= block_limit)
+      return -1;
+
+    block *b = new block;
+    b->x = x;
+    b->y = y;
+    b->z = z;
+    b->changed = false;
+    b->queued = false;
+    for (int i = 0; i < BLOCK_VOXELS; ++i) {
+      b->voxels[i].sdf = SDF_SCALE;
+      b->voxels[i].weight = 0;
+    }
+    table[slot] = int(blocks.size());
+    blocks.push_back(b);
+    return table[slot];
+  }
+
+  /* Allocate the blocks within the truncation band of sampled pixels */
+  void allocate(const uint16_t *depth) {
+    int w = tables.width(), h = tables.height();
+    float block_size = voxel * BLOCK;
+    int last_x = 0, last_y = 0, last_z = 0;
+    bool have_last = false;
+
+    for (int yy = 0; yy < h; yy += ALLOCATE_STRIDE) {
+      for (int xx = 0; xx < w; xx += ALLOCATE_STRIDE) {
+        uint16_t disp = depth[yy * w + xx];
+        if (disp >= invalid_depth)
+          continue;
+        float d = tables.meters(disp);
+        if (d <= 0)
+          continue;
+
+        // Near, on and beyond the surface along the view ray.
+        for (int step = -1; step <= 1; ++step) {
+          float z = d + step * truncation;
+          int bx = floorDiv(tables.rayX(xx) * z, block_size);
+          int by = floorDiv(tables.rayY(yy) * z, block_size);
+          int bz = floorDiv(z, block_size);
+          if (have_last && bx == last_x && by == last_y && bz == last_z)
+            continue;
+          findOrAllocate(bx, by, bz);
+          last_x = bx; last_y = by; last_z = bz;
+          have_last = true;
+        }
+      }
+    }
+  }
+
+  /* Fuse depth into the voxels of one block */
+  void integrateBlock(block &b, const uint16_t *depth) const {
+    int w = tables.width(), h = tables.height();
+    float fov = tables.pixelFieldOfView();
+    float half_w = w * 0.5f, half_h = h * 0.5f;
+    bool changed = false;
+
+    for (int k = 0; k < BLOCK; ++k) {
+      float z = (b.z * BLOCK + k) * voxel;
+      if (z <= voxel)
+        continue;  // At or behind the Kinect.
+      float to_pixel = 1 / (z * fov);
+
+      for (int j = 0; j < BLOCK; ++j) {
+        float y = (b.y * BLOCK + j) * voxel;
+        int py = int(floorf(half_h - y * to_pixel + 0.5f));
+        if (py < 0 || py >= h)
+          continue;
+        const uint16_t *row = depth + py * w;
+        voxel_data *v = &b.voxels[(k * BLOCK + j) * BLOCK];
+
+        for (int i = 0; i < BLOCK; ++i) {
+          float x = (b.x * BLOCK + i) * voxel;
+          int px = int(floorf(x * to_pixel + half_w + 0.5f));
+          if (px < 0 || px >= w)
+            continue;
+          uint16_t disp = row[px];
+          if (disp >= invalid_depth)
+            continue;
+          float sdf = tables.meters(disp) - z;
+          if (sdf < -truncation)
+            continue;  // Hidden behind the surface.
+
+          float tsdf = sdf < truncation ? sdf / truncation : 1;
+          unsigned weight = v[i].weight;
+          int old_sdf = v[i].sdf;
+          int new_sdf = int((old_sdf * float(weight) + tsdf * SDF_SCALE) / (weight + 1));
+          if (weight < MAX_WEIGHT)
+            v[i].weight = uint16_t(weight + 1);
+          v[i].sdf = int16_t(new_sdf);
+
+          int step = new_sdf > old_sdf ? new_sdf - old_sdf : old_sdf - new_sdf;
+          if (step > REMESH_STEP || (new_sdf < 0) != (old_sdf < 0) ||
+              weight + 1 == MIN_WEIGHT)
+            changed = true;
+        }
+      }
+    }
+    if (changed)
+      b.changed = true;
+  }
+
+  /* Marching cubes over the cubes whose lowest corner is in block b */
+  void extractBlock(block &b) const {
+    // Gather the block and the first layer of its neighbours after it.
+    const int SIDE = BLOCK + 1;
+    float sdf[SIDE * SIDE * SIDE];
+    bool seen[SIDE * SIDE * SIDE];
+    const block *neighbours[8];
+    for (int n = 0; n < 8; ++n) {
+      int index = n == 0 ? -1 : find(b.x + (n & 1), b.y + (n >> 1 & 1), b.z + (n >> 2 & 1));
+      neighbours[n] = n == 0 ? &b : index >= 0 ? blocks[index] : NULL;
+    }
+    for (int k = 0; k < SIDE; ++k)
+      for (int j = 0; j < SIDE; ++j)
+        for (int i = 0; i < SIDE; ++i) {
+          int n = (i == BLOCK) | (j == BLOCK) << 1 | (k == BLOCK) << 2;
+          int g = (k * SIDE + j) * SIDE + i;
+          const block *from = neighbours[n];
+          if (!from) {
+            seen[g] = false;
+            continue;
+          }
+          const voxel_data &v = from->voxels[((k % BLOCK) * BLOCK + j % BLOCK) * BLOCK + i % BLOCK];
+          seen[g] = v.weight >= MIN_WEIGHT;
+          sdf[g] = v.sdf * (1.0f / SDF_SCALE);
+        }
+
+    b.mesh.clear();
+    for (int k = 0; k < BLOCK; ++k)
+      for (int j = 0; j < BLOCK; ++j)
+        for (int i = 0; i < BLOCK; ++i)
+          extractCube(b, sdf, seen, i, j, k);
+  }
+
+  void extractCube(block &b, const float *sdf, const bool *seen, int i, int j, int k) const {
+    const int SIDE = BLOCK + 1;
+    float s[8];
+    int cube = 0;
+    for (int c = 0; c < 8; ++c) {
+      int g = ((k + (c >> 2 & 1)) * SIDE + j + (c >> 1 & 1)) * SIDE + i + (c & 1);
+      if (!seen[g])
+        return;
+      s[c] = sdf[g];
+      if (s[c] < 0)
+        cube |= 1 << c;
+    }
+    if (cube == 0 || cube == 255)
+      return;
+
+    // Cube origin in global voxel coordinates.
+    int gx = b.x * BLOCK + i, gy = b.y * BLOCK + j, gz = b.z * BLOCK + k;
+
+    // Vertex on each crossed edge.
+    float vertex[marching_cubes::EDGES][FLOATS_PER_VERTEX];
+    for (int e = 0; e < marching_cubes::EDGES; ++e) {
+      int c0 = cubes.edgeCorner(e, 0), c1 = cubes.edgeCorner(e, 1);
+      if ((s[c0] < 0) == (s[c1] < 0))
+        continue;
+      if (fabsf(s[c0] - s[c1]) > maxEdgeStep())
+        return;
+
+      float t = s[c0] / (s[c0] - s[c1]);
+      float f[3];
+      for (int axis = 0; axis < 3; ++axis) {
+        float a = float(c0 >> axis & 1), d = float(c1 >> axis & 1) - a;
+        f[axis] = a + t * d;
+      }
+      float *out = vertex[e];
+      out[0] = (gx + f[0]) * voxel;
+      out[1] = (gy + f[1]) * voxel;
+      out[2] = (gz + f[2]) * voxel;
+      gradient(s, f, out + 3);
+    }
+
+    const uint8_t *edges = cubes.triangleEdges(cube);
+    unsigned count = cubes.triangleCount(cube) * 3;
+    for (unsigned n = 0; n < count; ++n)
+      b.mesh.insert(b.mesh.end(), vertex[edges[n]], vertex[edges[n]] + FLOATS_PER_VERTEX);
+  }
+
+  /* Unit gradient, pointing outside, of the trilinear interpolation of the
+     cube's corner distances s at f, in cube units. */
+  static void gradient(const float *s, const float *f, float *out) {
+    float x = f[0], y = f[1], z = f[2];
+    float gx = (1 - y) * (1 - z) * (s[1] - s[0]) + y * (1 - z) * (s[3] - s[2]) +
+               (1 - y) * z * (s[5] - s[4]) + y * z * (s[7] - s[6]);
+    float gy = (1 - x) * (1 - z) * (s[2] - s[0]) + x * (1 - z) * (s[3] - s[1]) +
+               (1 - x) * z * (s[6] - s[4]) + x * z * (s[7] - s[5]);
+    float gz = (1 - x) * (1 - y) * (s[4] - s[0]) + x * (1 - y) * (s[5] - s[1]) +
+               (1 - x) * y * (s[6] - s[2]) + x * y * (s[7] - s[3]);
+    float length = sqrtf(gx * gx + gy * gy + gz * gz);
+    float scale = length > 0 ? 1 / length : 0;
+    out[0] = gx * scale;
+    out[1] = gy * scale;
+    out[2] = gz * scale;
+  }
+
+  class integrate_task : public parallel_task {
+  public:
+    integrate_task(tsdf_volume &volume_, const uint16_t *depth_)
+    : volume(volume_), depth(depth_) {}
+    void run(unsigned begin, unsigned end) {
+      for (unsigned i = begin; i < end; ++i)
+        volume.integrateBlock(*volume.blocks[i], depth);
+    }
+  private:
+    tsdf_volume &volume;
+    const uint16_t *depth;
+  };
+
+  class extract_task : public parallel_task {
+  public:
+    explicit extract_task(tsdf_volume &volume_) : volume(volume_) {}
+    void run(unsigned begin, unsigned end) {
+      for (unsigned i = begin; i < end; ++i)
+        volume.extractBlock(*volume.blocks[volume.remesh[i]]);
+    }
+  private:
+    tsdf_volume &volume;
+  };
+
+  const kinect_depth_tables &tables;
+  uint16_t invalid_depth;
+  float voxel;                  /* voxel edge, meters */
+  float truncation;             /* meters */
+  unsigned block_limit;
+  marching_cubes cubes;
+  std::vector<int> table;       /* open addressed, index into blocks or -1 */
+  std::vector<block*> blocks;
+  std::vector<int> remesh;      /* blocks meshed by the last extract */
+};
+
+#endif //#ifndef FILE_TSDF_VOLUME_H_INCLUDED
@@ -0,0 +1,224 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   10-17-2026
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+
+// vertex_stream.h
+// GPU vertex buffer that a capture thread writes frames into directly.
+// There is no associated source file.
+// Requires GLEW and LibOVR's Kernel/OVR_Atomic.h.
+//
+// Before including this file, you must include glew.h (glslprog.h does).
+//
+// The buffer holds 3 slots, one for each slot of the triple_buffer the
+// frames are handed off through. With GL_ARB_buffer_storage the whole
+// buffer is persistently mapped, the producer writes vertices straight into
+// it, and draws read them with no copy at all. Each slot gets a fence after
+// the renderer's last draw from it; the producer does not write into a slot
+// until the renderer has seen that fence pass.
+//
+// Without GL_ARB_buffer_storage, slots are ordinary memory and use()
+// uploads a new frame into the buffer once, instead of once per draw.
+// With partial updates each slot keeps its own copy on the GPU, and use()
+// uploads only the ranges the producer rewrote.
+//
+// Thread use:
+//   renderer (GL context current): create, use, fence, retire, destroy
+//   producer:                      beginWrite
+
+#ifndef FILE_VERTEX_STREAM_H_INCLUDED
+#define FILE_VERTEX_STREAM_H_INCLUDED
+
+#include "Kernel/OVR_Atomic.h"
+
+#include <stdint.h>
+#include <unistd.h>  // For usleep
+#include <vector>
+
+class vertex_stream {
+public:
+  static const int SLOTS = 3;
+
+  vertex_stream()
+  : buffer(0), slot_floats(0), mapped(NULL), persistent(false), partial(false),
+    streamed_bytes(0)
+  {
+    for (int i = 0; i < SLOTS; ++i) {
+      fences[i] = 0;
+      busy[i] = 0;
+    }
+  }
+
+  /* Create buffer with room for slot_floats_ floats per slot. With
+     partial_updates, use() is given the ranges that changed. */
+  void create(unsigned slot_floats_, bool partial_updates = false) {
+    slot_floats = slot_floats_;
+    partial = partial_updates;
+    GLsizeiptr bytes = GLsizeiptr(SLOTS) * slotBytes();
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    persistent = GLEW_ARB_buffer_storage && GLEW_ARB_sync;
+    if (persistent) {
+      const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+      glBufferStorage(GL_ARRAY_BUFFER, bytes, NULL, flags);
+      mapped = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags));
+      if (!mapped) {
+        // Driver advertised buffer storage but won't map it, fall back.
+        glDeleteBuffers(1, &buffer);
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        persistent = false;
+      }
+    }
+
+    if (!persistent) {
+      glBufferData(GL_ARRAY_BUFFER, partial ? bytes : slotBytes(), NULL, GL_STREAM_DRAW);
+      staging.resize(size_t(SLOTS) * slot_floats);
+      mapped = &staging.front();
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  void destroy() {
+    for (int i = 0; i < SLOTS; ++i) {
+      if (fences[i]) glDeleteSync(fences[i]);
+      fences[i] = 0;
+    }
+    if (persistent) {
+      glBindBuffer(GL_ARRAY_BUFFER, buffer);
+      glUnmapBuffer(GL_ARRAY_BUFFER);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    mapped = NULL;
+  }
+
+  GLuint bufferId() const { return buffer; }
+  bool isPersistent() const { return persistent; }
+  unsigned slotCapacity() const { return slot_floats; }
+
+  /* Bytes of new frames handed to the GPU, written through the mapping
+     or uploaded by use() */
+  uint64_t streamedBytes() const { return streamed_bytes; }
+
+  // *** Producer
+
+  /* Memory to write slot's vertices into. Waits up to timeout_ms for the
+     GPU to finish with the slot, returns NULL if it still hasn't. */
+  float *beginWrite(int slot, unsigned timeout_ms = 50) {
+    for (unsigned waited = 0; busy[slot].Load_Acquire(); ++waited) {
+      if (waited >= timeout_ms)
+        return NULL;
+      usleep(1000);
+    }
+    return mapped + size_t(slot) * slot_floats;
+  }
+
+  // *** Renderer
+
+  /* Make slot's first floats vertices available to draws.
+     is_new is true the first time a slot is used after being written.
+     With partial updates, ranges holds [begin, end) pairs of the floats
+     written since the slot was last used, and floats is ignored.
+     Returns the byte offset of the vertices in bufferId(). */
+  GLintptr use(int slot, unsigned floats, bool is_new,
+               const std::vector<unsigned> *ranges = NULL) {
+    if (partial) {
+      if (is_new)
+        useRanges(slot, *ranges);
+      return GLintptr(slot) * slotBytes();
+    }
+
+    if (is_new)
+      streamed_bytes += floats * sizeof(float);
+
+    if (persistent)
+      return GLintptr(slot) * slotBytes();
+
+    if (is_new) {
+      // Orphan the old storage so the upload doesn't wait on last frame's draws.
+      glBindBuffer(GL_ARRAY_BUFFER, buffer);
+      glBufferData(GL_ARRAY_BUFFER, slotBytes(), NULL, GL_STREAM_DRAW);
+      glBufferSubData(GL_ARRAY_BUFFER, 0, floats * sizeof(float),
+                      mapped + size_t(slot) * slot_floats);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    return 0;
+  }
+
+  /* Call after the last draw reading slot this frame */
+  void fence(int slot) {
+    if (!persistent)
+      return;
+    busy[slot] = 1;
+    if (fences[slot]) glDeleteSync(fences[slot]);
+    fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+
+  /* Call once per frame. Frees slots the GPU has finished reading. */
+  void retire() {
+    for (int i = 0; i < SLOTS; ++i) {
+      if (!fences[i])
+        continue;
+      GLenum status = glClientWaitSync(fences[i], 0, 0);
+      if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+        glDeleteSync(fences[i]);
+        fences[i] = 0;
+        busy[i] = 0;
+      }
+    }
+  }
+
+private:
+  GLsizeiptr slotBytes() const { return GLsizeiptr(slot_floats) * sizeof(float); }
+
+  /* Upload ranges of slot to its copy on the GPU, if it isn't mapped */
+  void useRanges(int slot, const std::vector<unsigned> &ranges) {
+    const float *slot_data = mapped + size_t(slot) * slot_floats;
+    if (!persistent)
+      glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (size_t i = 0; i + 1 < ranges.size(); i += 2) {
+      unsigned begin = ranges[i], end = ranges[i + 1];
+      streamed_bytes += (end - begin) * sizeof(float);
+      if (!persistent)
+        glBufferSubData(GL_ARRAY_BUFFER, GLintptr(slot) * slotBytes() + begin * sizeof(float),
+                        (end - begin) * sizeof(float), slot_data + begin);
+    }
+    if (!persistent)
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  GLuint buffer;
+  unsigned slot_floats;
+  float *mapped;                    /* slot memory, GPU mapped or staging */
+  bool persistent;
+  bool partial;                     /* use() uploads only changed ranges */
+  std::vector<float> staging;       /* slot memory without buffer storage */
+  uint64_t streamed_bytes;
+  GLsync fences[SLOTS];
+  OVR::AtomicInt<int> busy[SLOTS];  /* GPU may still be reading slot */
+};
+
+#endif //#ifndef FILE_VERTEX_STREAM_H_INCLUDED
@@ -0,0 +1,129 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   4-20-2015
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+ 
+// Unprojects the raw Kinect depth image on the GPU.
+// Each vertex of the static grid mesh is one sample of the depth image.
+// So I can use things like gl_Vertex to save time/effort.
+#version 150 compatibility
+
+uniform usampler2D depth_image;  // Raw disparities, one texel per grid vertex
+uniform sampler2D depth_meters;  // 2048 x 1 disparity to meters table
+uniform int stride;              // Depth pixels between grid vertices
+uniform vec2 image_center;       // Center of depth image in pixels
+uniform float pixel_fov;         // Unit-depth field of view offset per pixel
+
+// Hole filling on the GPU, see lib/gpu_hole_filler.h.
+uniform bool fill_holes;         // Read filled_depth instead of depth_image
+uniform sampler2D filled_depth;  // Disparity and confidence per grid vertex
+
+uniform mat4 eye_mvp[2];   // Model view projection matrix for each eye
+uniform bool side_by_side; // Instance i is drawn into the i-th half of the target
+
+// Point sprites, see points_f.glsl. Unused when drawing triangles.
+uniform float point_scale[2]; // Sprite pixels per meter of depth at w of 1, per eye
+uniform bool cull_points;     // Move points without depth out of view
+
+// Culling without a geometry shader, same test as lib/mesh_culling.h.
+uniform bool cull_vertices; // Make vertices ending a long edge NaN
+uniform float max_edge;     // Edges at least this long, in meters, are dropped
+uniform float not_a_number; // NaN, GLSL 1.50 has no way to write one
+
+out vec3 vertex;
+out vec2 tex_coords;
+out vec2 uv;         // tex_coords, when there is no geometry shader
+out float vertex_confidence; // Passed to geometry shader
+out float confidence;        // vertex_confidence, when there is no geometry shader
+
+// Raw disparity of a grid vertex, hole filled or not.
+uint disparity(ivec2 grid) {
+    if (fill_holes) {
+        vec2 filled = texelFetch(filled_depth, grid, 0).rg;
+        return filled.y > 0.0 ? uint(filled.x + 0.5) : 2047u;
+    }
+    return texelFetch(depth_image, grid, 0).r;
+}
+
+// Unproject the depth sample of a grid vertex, same as kinect_depth_tables.
+vec3 unproject(ivec2 grid) {
+    uint disp = min(disparity(grid), 2047u);
+    float depth = texelFetch(depth_meters, ivec2(int(disp), 0), 0).r;
+
+    // Project view ray out for that pixel.
+    vec2 pixel = vec2(grid * stride);
+    vec2 ray = vec2(pixel.x - image_center.x, image_center.y - pixel.y) * pixel_fov;
+    return vec3(ray * depth, depth);
+}
+
+// True if the vertex has no depth, or a long edge to its right, lower or
+// lower left neighbour. Every long edge has one of these at an end.
+bool culled(ivec2 grid, vec3 location) {
+    if (!(location.z > 0.0))
+        return true;
+    ivec2 size = textureSize(depth_image, 0);
+    if (grid.x + 1 < size.x && distance(location, unproject(grid + ivec2(1, 0))) >= max_edge)
+        return true;
+    if (grid.y + 1 < size.y) {
+        if (distance(location, unproject(grid + ivec2(0, 1))) >= max_edge)
+            return true;
+        if (grid.x > 0 && distance(location, unproject(grid + ivec2(-1, 1))) >= max_edge)
+            return true;
+    }
+    return false;
+}
+
+void main() {
+    // gl_Vertex.xy is the column and row of this vertex in the grid.
+    ivec2 grid = ivec2(gl_Vertex.xy);
+    vec4 location = vec4(unproject(grid), 1.0);
+
+    vertex = location.xyz; // Unmodified coordinates passed to geometry shader
+
+    // A NaN position makes the GPU discard the triangles using this vertex.
+    if (cull_vertices && culled(grid, location.xyz))
+        location = vec4(not_a_number);
+
+    // One instance per eye, see invalids_v.glsl.
+    vec4 position = eye_mvp[gl_InstanceID] * location;
+
+    if (side_by_side) {
+        float side = gl_InstanceID == 0 ? -1.0 : 1.0;
+        position.x = 0.5 * position.x + 0.5 * side * position.w;
+        gl_ClipDistance[0] = side * position.x;
+    } else {
+        gl_ClipDistance[0] = 1.0;
+    }
+
+    gl_Position = position;
+
+    // Points grow with depth as the samples spread apart, and shrink with
+    // distance from the eye, so they cover what the mesh would have.
+    gl_PointSize = max(point_scale[gl_InstanceID] * vertex.z / position.w, 1.0);
+    if (cull_points && !(vertex.z > 0.0))
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);  // Beyond the far plane
+
+    tex_coords = gl_MultiTexCoord0.st;
+    uv = tex_coords;
+
+    vertex_confidence = fill_holes ? texelFetch(filled_depth, grid, 0).g : 1.0;
+    confidence = vertex_confidence;
+}
\ No newline at end of file
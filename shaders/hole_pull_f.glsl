@@ -0,0 +1,61 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   4-20-2015
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+ 
+// Pull pass of hole filling, see lib/depth_hole_filler.h.
+// Each output texel is the weighted average of its 2x2 children, as
+// (disparity, weight).
+#version 150
+
+uniform usampler2D depth_image; // Raw disparities, pulled into the first level
+uniform sampler2D finer;        // Level below as (disparity, weight), after that
+uniform bool from_depth;        // Children are in depth_image
+uniform uint invalid_depth;     // Disparities at or above this have no depth
+
+out vec2 pulled;
+
+// Disparity and weight of a child.
+vec2 child(ivec2 texel) {
+    if (from_depth) {
+        uint disp = texelFetch(depth_image, texel, 0).r;
+        return disp < invalid_depth ? vec2(float(disp), 1.0) : vec2(0.0);
+    }
+    return texelFetch(finer, texel, 0).rg;
+}
+
+void main() {
+    ivec2 size = from_depth ? textureSize(depth_image, 0) : textureSize(finer, 0);
+    ivec2 base = ivec2(gl_FragCoord.xy) * 2;
+
+    float weight = 0.0;
+    float sum = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        ivec2 texel = base + ivec2(i & 1, i >> 1);
+        if (texel.x < size.x && texel.y < size.y) {
+            vec2 c = child(texel);
+            weight += c.y;
+            sum += c.x * c.y;
+        }
+    }
+
+    pulled = weight > 0.0 ? vec2(sum / weight, min(weight, 1.0)) : vec2(0.0);
+}
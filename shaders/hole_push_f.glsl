@@ -0,0 +1,83 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   4-20-2015
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+ 
+// Push pass of hole filling, see lib/depth_hole_filler.h.
+// Blends each texel with a bilinear sample of the level above, in
+// proportion to what its own weight is missing. Writes (disparity,
+// confidence); confidence 0 means still a hole.
+#version 150
+
+uniform usampler2D depth_image; // Raw disparities, when pushing into the first level
+uniform sampler2D finer;        // This level as pulled, (disparity, weight), after that
+uniform bool from_depth;        // This level is depth_image
+uniform sampler2D coarser;      // Level above, already pushed
+uniform uint invalid_depth;     // Disparities at or above this have no depth
+uniform float fade;             // Confidence kept by a texel filled from one level up
+
+out vec2 pushed;
+
+// Disparity and weight of a texel of this level.
+vec2 own(ivec2 texel) {
+    if (from_depth) {
+        uint disp = texelFetch(depth_image, texel, 0).r;
+        return disp < invalid_depth ? vec2(float(disp), 1.0) : vec2(0.0);
+    }
+    return texelFetch(finer, texel, 0).rg;
+}
+
+void tap(ivec2 texel, float bilinear, inout float weight, inout float sum) {
+    vec2 c = texelFetch(coarser, texel, 0).rg;
+    float w = bilinear * c.y;
+    weight += w;
+    sum += w * c.x;
+}
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec2 fine = own(texel);
+    if (fine.y >= 1.0) {
+        pushed = fine;
+        return;
+    }
+
+    // The parent and its nearest neighbour towards this texel, weighted
+    // 3/4 and 1/4 in each direction.
+    ivec2 size = textureSize(coarser, 0);
+    ivec2 parent = texel / 2;
+    ivec2 toward = ivec2((texel.x & 1) == 1 ? 1 : -1, (texel.y & 1) == 1 ? 1 : -1);
+    ivec2 near = clamp(parent + toward, ivec2(0), size - 1);
+
+    float weight = 0.0;
+    float sum = 0.0;
+    tap(parent, 0.5625, weight, sum);
+    tap(ivec2(near.x, parent.y), 0.1875, weight, sum);
+    tap(ivec2(parent.x, near.y), 0.1875, weight, sum);
+    tap(near, 0.0625, weight, sum);
+
+    float total = fine.y + (1.0 - fine.y) * weight;
+    if (total > 0.0)
+        pushed = vec2((fine.y * fine.x + (1.0 - fine.y) * sum) / total,
+                      fine.y + (1.0 - fine.y) * weight * fade);
+    else
+        pushed = fine;
+}
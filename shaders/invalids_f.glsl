@@ -21,12 +21,16 @@
  * either License.
  */
  
+// Declared so drivers that follow the spec accept in and out.
+#version 150 compatibility
+
  // direction of light source, hard coded
 const vec3 source = vec3(0,0,1);
 
 uniform sampler2D texture; // RGB image from kinect
 
 in vec2 uv;                // Texture coordinates to sample
+in float confidence;       // Of filled in holes, 1 if measured
 //in vec3 surface_normal;    // Used for virtual lighting
 
 void main() {
@@ -38,5 +42,8 @@ void main() {
     float intensity = 1.0;
     
 	vec4 color = texture2D(texture, uv);
-    gl_FragColor = vec4(color.xyz * intensity + color.xyz * .5, 1);
+
+    // Filled in holes fade to grey as their confidence drops.
+    vec3 shade = mix(vec3(.25), color.xyz, confidence);
+    gl_FragColor = vec4(shade * intensity + shade * .5, 1);
 }
\ No newline at end of file
@@ -21,18 +21,62 @@
  * either License.
  */
  
-// So I can use things like gl_ModelViewProjectionMatrix to save time/effort.
+// So I can use things like gl_Vertex to save time/effort.
 // Ideally, the shaders should use modern glsl specification.
-#version 150
+#version 150 compatibility
+
+uniform mat4 eye_mvp[2];   // Model view projection matrix for each eye
+uniform bool side_by_side; // Instance i is drawn into the i-th half of the target
+
+// Point sprites, see points_f.glsl. Unused when drawing triangles.
+uniform float point_scale[2]; // Sprite pixels per meter of depth at w of 1, per eye
+uniform bool cull_points;     // Move points without depth out of view
+
+// Hole filling on the depth thread, see lib/depth_hole_filler.h.
+uniform bool fill_holes;           // Fade vertices by fill_confidence
+uniform sampler2D fill_confidence; // Confidence of every vertex, 1 if measured
 
 //out vec4 v_color;
 out vec3 vertex;
 out vec2 tex_coords;
+out vec2 uv;         // tex_coords, when there is no geometry shader
+out float vertex_confidence; // Passed to geometry shader
+out float confidence;        // vertex_confidence, when there is no geometry shader
 
 void main() {
     vertex = gl_Vertex.xyz; // Unmodified coordinates passed to geometry shader
 
-    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+    // One instance per eye.
+    // Vertices the depth thread culled are NaN, so their position is too,
+    // and the GPU discards the triangles using them.
+    vec4 position = eye_mvp[gl_InstanceID] * gl_Vertex;
+
+    if (side_by_side) {
+        // Squeeze x into the left (eye 0) or right (eye 1) half, and clip
+        // away anything that would spill into the other eye's half.
+        float side = gl_InstanceID == 0 ? -1.0 : 1.0;
+        position.x = 0.5 * position.x + 0.5 * side * position.w;
+        gl_ClipDistance[0] = side * position.x;
+    } else {
+        gl_ClipDistance[0] = 1.0;
+    }
+
+    gl_Position = position;
+
+    // Points grow with depth as the samples spread apart, and shrink with
+    // distance from the eye, so they cover what the mesh would have.
+    gl_PointSize = max(point_scale[gl_InstanceID] * gl_Vertex.z / position.w, 1.0);
+    if (cull_points && !(gl_Vertex.z > 0.0))
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);  // Beyond the far plane
 
     tex_coords = gl_MultiTexCoord0.st;
+    uv = tex_coords;
+
+    // Vertices are in grid order, one texel each.
+    vertex_confidence = 1.0;
+    if (fill_holes) {
+        int cols = textureSize(fill_confidence, 0).x;
+        vertex_confidence = texelFetch(fill_confidence, ivec2(gl_VertexID % cols, gl_VertexID / cols), 0).r;
+    }
+    confidence = vertex_confidence;
 }
\ No newline at end of file
@@ -21,30 +21,42 @@
  * either License.
  */
  
+// Declared so drivers that follow the spec accept in and out.
+#version 150 compatibility
+
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+
 const int SIZE = 3;
-const float INVALID = 0;
+const float INVALID = 0.0;
 
 in vec3 vertex[SIZE];       // Incoming from vertex shader
 in vec2 tex_coords[SIZE];   // Incoming from vertex shader
+in float vertex_confidence[SIZE]; // Incoming from vertex shader
 
 out vec2 uv;
+out float confidence;      // Of filled in holes, 1 if measured
 //out vec3 surface_normal; // Used for virtual lighting
 
 void main() {
-    // Find 2 sides of triangle
+    // Find the sides of triangle
     vec3 vector1 = vertex[1] - vertex[0];
     vec3 vector2 = vertex[2] - vertex[0];
+    vec3 vector3 = vertex[2] - vertex[1];
 
     // Uncomment the following for virtual lighting
     //vec3 normal = cross(vector1, vector2);
     
-    // Only draw triangles that do not have a "long" side 
-    if( length(vector1) < .1 && length(vector2) < .1 ) {
+    // Only draw triangles that do not have a "long" side, same test as
+    // lib/mesh_culling.h
+    if( length(vector1) < .1 && length(vector2) < .1 && length(vector3) < .1 ) {
         
         for(int i = 0; i < SIZE; ++i) {
             gl_Position = gl_in[i].gl_Position;
+            gl_ClipDistance[0] = gl_in[i].gl_ClipDistance[0]; // Side by side stereo
             //surface_normal = normal; // Used for virtual lighting
             uv = tex_coords[i];
+            confidence = vertex_confidence[i];
             
             EmitVertex();
         }
@@ -0,0 +1,44 @@
+/* Author: Shaun Bond (samuraicodemonkey@gmail.com)
+ * Date:   4-20-2015
+ *
+ * This code is licensed to you under the terms of the Apache License, version
+ * 2.0, or, at your option, the terms of the GNU General Public License,
+ * version 2.0. See the APACHE20 and GPL2 files for the text of the licenses,
+ * or the following URLs:
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * If you redistribute this file in source form, modified or unmodified, you
+ * may:
+ *   1) Leave this header intact and distribute it under the same terms,
+ *      accompanying it with the APACHE20 and GPL20 files, or
+ *   2) Delete the Apache 2.0 clause and accompany it with the GPL2 file, or
+ *   3) Delete the GPL v2 clause and accompany it with the APACHE20 file
+ * In all cases you must keep the copyright notice intact and include a copy
+ * of the CONTRIB file.
+ *
+ * Binary distributions must follow the binary distribution requirements of
+ * either License.
+ */
+ 
+// Round point sprites for drawing the Kinect mesh as a point cloud.
+// Colored the same as invalids_f.glsl.
+#version 150 compatibility
+
+uniform sampler2D texture; // RGB image from kinect
+
+in vec2 uv;                // Texture coordinates to sample
+in float confidence;       // Of filled in holes, 1 if measured
+
+void main() {
+    // Drop the corners of the square sprite.
+    vec2 offset = gl_PointCoord * 2.0 - 1.0;
+    if (dot(offset, offset) > 1.0)
+        discard;
+
+    vec4 color = texture2D(texture, uv);
+
+    // Filled in holes fade to grey as their confidence drops.
+    vec3 shade = mix(vec3(.25), color.xyz, confidence);
+    gl_FragColor = vec4(shade * 1.5, 1);
+}
@@ -26,7 +26,6 @@
 
 #include "libfreenect.hpp"
 #include "lib/glslprog.h"
-#include <pthread.h>
 
 #include <iostream>
 using std::cerr;
@@ -39,15 +38,46 @@ using std::string;
 #include <vector>
 using std::vector;
 
+#include <map>
+using std::map;
+
+#include <limits>
+#include <cerrno>
+
 #include <algorithm>
 using std::copy;
+using std::max;
+using std::min;
 
 #include <iomanip>
 using std::setw;
 using std::fixed;
 using std::setprecision;
 
+#include <pthread.h>
+
 #include "lib/vec4.h"
+#include "lib/kinect_depth_tables.h"
+#include "lib/depth_unprojector.h"
+#include "lib/triple_buffer.h"
+#include "lib/vertex_stream.h"
+#include "lib/texture_stream.h"
+#include "lib/gpu_hole_filler.h"
+#include "lib/kinect_recording.h"
+#include "lib/depth_codec.h"
+#include "lib/frame_profiler.h"
+#include "lib/gpu_timer.h"
+#include "lib/kinect_latency.h"
+#include "lib/synthetic_kinect.h"
+#include "lib/headless_gl.h"
+#include "lib/mesh_culling.h"
+#include "lib/depth_tiles.h"
+#include "lib/depth_filter.h"
+#include "lib/depth_hole_filler.h"
+#include "lib/depth_worker.h"
+#include "lib/parallel_for.h"
+#include "lib/depth_bands.h"
+#include "lib/tsdf_volume.h"
 #include "OVR.h"
 
 #include "OVR_CAPI_GL.h"
@@ -84,18 +114,142 @@ int saved_y = 0;
 unsigned texture_w = 0;
 unsigned texture_h = 0;
 
-vector<unsigned> indices;   // Vertex indices for triangle strip.
-vector<float> texCoords;    // Texture coordinates for triangle strip.
+// Index of vertex that ends one triangle strip and starts the next.
+const unsigned RESTART_INDEX = 0xFFFFFFFF;
+
+// How triangles spanning a depth discontinuity are dropped: by the
+// geometry shader, by drawing indices of only the rest, or by making a
+// vertex of each NaN. The last two draw without a geometry shader.
+enum MeshCulling {CULL_GEOMETRY_SHADER, CULL_COMPACT_INDICES, CULL_NAN_VERTICES};
+MeshCulling mesh_culling = CULL_GEOMETRY_SHADER;
+const float MAX_EDGE = .1;  // Triangles with an edge this long (meters) are dropped.
+
+// Mesh resolution. Every mesh_stride-th depth pixel in x and y is a vertex.
+const unsigned MAX_MESH_STRIDE = 8;
+unsigned user_mesh_stride = 2;  // Stride picked by user.
+unsigned mesh_stride = 2;       // Stride in use, may be coarser than user's with LOD.
+
+// Level of detail: draw points, then coarsen the mesh, when the work of a
+// frame gets close to this.
+bool lod_enabled = false;
+bool lod_points = false;  // Triangles are drawn as points to save time.
+const double FRAME_BUDGET = 1.0 / 75;  // DK2 refresh rate.
 
 ovrHmd hmd = NULL;
 ovrEyeRenderDesc eyeRenderDesc[2];
 ovrGLTexture eyeTextures[2];
 
+// Frame pacing: only render the eyes when the scene changed, or the head
+// moved further than timewarp hides well. Other frames hand LibOVR the
+// last eye textures with the poses they were rendered at, and timewarp
+// turns them to the current head orientation. Displays are only asked for
+// once a refresh, or sooner for a new Kinect frame, see displayDue.
+bool pace_frames = false;
+bool scene_changed = true;  // Set by anything that changes what is drawn.
+const float MAX_REUSE_TRANSLATION = .005;          // meters, timewarp only rotates
+const float MAX_REUSE_ROTATION = 5 * M_PI / 180;   // radians
+ovrPosef rendered_poses[2];  // Eye poses the eye textures were rendered at.
+unsigned rendered_frames = 0;
+unsigned reused_frames = 0;
+
+// Steady raw depth over time and between neighbours before converting it.
+bool filter_depth = false;
+
+// Fill small holes of invalid depth by push-pull, on the depth thread or on
+// the GPU over the depth texture. Filled vertices fade by their confidence.
+enum HoleFilling {FILL_NONE, FILL_CPU, FILL_GPU};
+HoleFilling hole_filling = FILL_NONE;
+
+// Only reconvert and upload the 16x16 depth tiles that moved more than this
+// many disparity units since they were last converted. -1 converts all.
+int dirty_tile_tolerance = -1;
+vector<mesh_region> upload_regions;  // Scratch for vertexUploadRanges.
+vector<unsigned> upload_ranges;      // Floats of a view's vertices to upload.
+
+// Fuse depth frames into a voxel grid, and draw the surface extracted from
+// it instead of each frame's mesh. Surfaces stay when they go out of view.
+bool fuse_depth = false;
+float fusion_voxel_size = .02;       // meters
+
+// Threads that depth frames are split over in bands of rows, and fusion
+// runs on. Each Kinect gets a pool of its own with an equal share, so one
+// Kinect's stages never queue behind another's. 0 uses every core, 1
+// converts on each worker thread alone.
+int pool_threads = 0;
+const int MAX_POOL_THREADS = 8;
+
 GLuint hide_invalid_vertices = 0;
-GLuint gl_rgb_tex;
+GLint eye_mvp_uniform = -1;      // mat4[2] model view projection per eye
+GLint side_by_side_uniform = -1; // bool, draw eyes into halves of target
+
+// Points are round sprites from the same vertices as the mesh, sized to
+// cover point_size depth samples whatever their distance.
+GLuint point_sprites = 0;
+GLint points_eye_mvp_uniform = -1;
+GLint points_side_by_side_uniform = -1;
+GLint point_scale_uniform = -1;    // float[2] sprite pixels per meter of depth at w of 1
+GLint points_stride_uniform = -1;
+float point_size = 1.5;            // Sprite diameter, in depth samples
+bool cull_invalid_points = true;   // Hide points without depth
+bool start_with_points = false;    // Start in the point display mode
+
+// Render both eyes into one side by side target in a single pass.
+bool single_pass_stereo = false;
+
+// Unproject raw depth in the vertex shader instead of on the depth thread.
+bool gpu_unproject = false;
+GLuint gl_depth_meters_tex = 0; // Disparity to meters table.
+GLint depth_stride_uniform = -1;
+
+// GPU time of each render pass, by eye where there is one per eye.
+gpu_timer gpu_timing;
+int gpu_cube[2];
+int gpu_mesh[2];
+int gpu_mesh_both = -1;  // Single pass stereo mesh.
+int gpu_hole_fill = -1;  // GPU hole filling passes.
+int gpu_track = -1;      // Frame trace track GPU timings go on.
+
+// Latency of Kinect frames from capture to display, published once a second.
+// Created after ovr_Initialize, they use LibOVR's allocator.
+kinect_latency_calculator *kinect_latency = NULL;
+OVR::ObserverScope<kinect_latency_slot> *kinect_latency_observer = NULL;
+kinect_latency_results latest_latency;  // Shown in status line.
 GLuint eye_tex[2];
 GLuint frame_buffers[2];
 
+// Recorded sessions. Record live frames to record_path, or replay
+// replay_paths instead of using Kinects.
+string record_path;
+vector<string> replay_paths;
+bool replay_fast = false;  // Replay, or make up frames, as fast as possible.
+
+// Number of Kinects, live or made up. Recordings are replayed one per
+// Kinect, round robin when there are more Kinects than recordings.
+const int MAX_KINECTS = 4;
+int kinect_count = 1;
+
+// Frame trace tracks: render, gpu and libfreenect, a capture and a depth
+// worker thread per Kinect, and the pool's helpers.
+typedef char trace_tracks_fit[3 + 2 * MAX_KINECTS + MAX_POOL_THREADS - 1
+                              <= frame_profiler::MAX_THREADS ? 1 : -1];
+
+// Where each Kinect is in the world, one "x y z yaw pitch roll" line per
+// Kinect in meters and degrees. Kinects without a line are placed at
+// DEFAULT_KINECT_POSITION.
+string extrinsics_path;
+const Vector3f DEFAULT_KINECT_POSITION(-.5, .4, 1.6);
+
+// Headless benchmark. Renders bench_frames frames offscreen with a debug
+// HMD, from a recording or synthetic frames, and writes a JSON report.
+unsigned bench_frames = 0;  // 0 when not benchmarking
+string bench_report_path = "bench_report.json";
+uint64_t depth_upload_bytes = 0;  // Raw depth uploaded for GPU unprojection
+
+// Where 'p' writes the recent stage timings. Also written at exit if it
+// was given on the command line.
+string trace_path = "frame_trace.json";
+bool trace_at_exit = false;
+
 double freenect_angle(0);
 int window(0);
 int g_argc;
@@ -112,172 +266,299 @@ char **g_argv;
     
   Assumes that depth image is 640 x 480
 
-  This class is curtesy of Dr. Orion Lawlor.  Used here in original form.
+  Disparity to meters conversion and view rays come from tables built once
+  at startup, so every pixel is a lookup instead of a tan().
+  The math is curtesy of Dr. Orion Lawlor's kinect_depth_image class.
 */
-class kinect_depth_image {
-public:
-  kinect_depth_image(const uint16_t *d_)
-  : depthi(d_), w(IMG_WIDTH), h(IMG_HEIGHT)
-  {
-    pixelFOV=tan(0.5 * (M_PI / 180.0) * 57.8)/(w*0.5);
-  }
-
-  /* Return depth, in meters, at this pixel */
-  float depth(int x,int y) const {
-    uint16_t disp=depthi[y*w+x];
-    if (disp>= INVALID_DEPTH) return 0.0;
-
-    //From Stephane Magnenat's depth-to-distance conversion function:
-    return 0.1236 * tan(disp / 2842.5 + 1.1863) - 0.037; // (meters)
-  }
-
-  /* Return 3D direction pointing from the sensor out through this pixel
-       (not a unit vector) */
-  vec3 dir(int x,int y) const {
-    // Ypix = -Ydist / (pixelFOV*Depth) + .5h
-    return vec3((x-w*0.5)*pixelFOV, (h*0.5-y)*pixelFOV, 1);
-  }
-
-  /* Return 3D location, in meters, at this pixel */
-  vec3 loc(int x,int y) const {
-    // Project view ray out for that pixel
-    return dir(x,y)*depth(x,y);
-  }
+const kinect_depth_tables depth_tables(IMG_WIDTH, IMG_HEIGHT, INVALID_DEPTH);
 
-private:
-  const uint16_t *depthi;
-  int w, h;       /* dimensions of image */
-  float pixelFOV; /* Unit-depth field of view offset per X or Y pixel */
+
+// Video texture coordinates of depth pixel (x,y). The video camera sees a
+// little more than the depth camera.
+void videoTexCoord(float x, float y, float &s, float &t)
+{
+    const float fovCorrection = .92185;
+    const float offset = (1 - fovCorrection) / 2;
+    s = x / IMG_WIDTH * fovCorrection + offset;
+    t = y / IMG_HEIGHT * fovCorrection + 1.5 * offset;
+}
+
+
+// A depth frame converted to vertices, handed from depth thread to renderer.
+struct VertexFrame {
+    int slot;               // Slot of the vertex stream holding the vertices
+    float *vertices;        // x,y,z per vertex, in slot's memory
+    unsigned count;         // Number of vertices
+    unsigned stride;        // Mesh stride vertices were built with
+    unsigned index_count;   // Compacted triangle indices, after the vertices
+    vector<uint8_t> upload_tiles; // Tiles rewritten since the renderer last uploaded
+    vector<uint8_t> confidence;   // Hole filling confidence per vertex, 255 if measured
+    uint64_t capture_nanos; // When the depth frame arrived
+    uint64_t handoff_nanos; // When the vertices were published
 };
 
-/* Borrowed this class from cppview.cpp.  Used here in original form. */
-class Mutex {
-public:
-    Mutex() {
-        pthread_mutex_init( &m_mutex, NULL );
-    }
-    void lock() {
-        pthread_mutex_lock( &m_mutex );
-    }
-    void unlock() {
-        pthread_mutex_unlock( &m_mutex );
-    }
+// A raw depth frame for unprojecting on the GPU, handed from depth thread
+// to renderer. Holds only the pixels that become mesh vertices.
+struct DepthFrame {
+    vector<uint16_t> pixels; // cols * rows disparities
+    unsigned cols, rows;     // Size of mesh grid
+    unsigned stride;         // Mesh stride pixels were sampled with
+    uint64_t capture_nanos;  // When the depth frame arrived
+    uint64_t handoff_nanos;  // When the pixels were published
+};
 
-    class ScopedLock
-    {
-        Mutex & _mutex;
-    public:
-        ScopedLock(Mutex & mutex)
-    : _mutex(mutex)
-    {
-            _mutex.lock();
-    }
-        ~ScopedLock()
-        {
-            _mutex.unlock();
-        }
-    };
-private:
-    pthread_mutex_t m_mutex;
+// A mesh extracted from fused depth frames, handed from depth thread to
+// renderer. Published only when the mesh changed.
+struct FusedFrame {
+    static const unsigned FLOATS_PER_VERTEX = 8;
+    vector<float> vertices; // x,y,z, normal x,y,z, texture s,t per vertex
+    unsigned count;         // Number of vertices, three per triangle
+    uint64_t capture_nanos; // When the last fused depth frame arrived
+    uint64_t handoff_nanos; // When the mesh was published
+};
+
+// A video frame, handed from video thread to renderer.
+struct RGBFrame {
+    const uint8_t *data;    // IMG_WIDTH * IMG_HEIGHT rgb pixels
+    vector<uint8_t> pixels; // Copy of a live frame, data points here
 };
 
 
-/* Borrowed this class from cppview.cpp. Used here in a heavily modified form */
-class MyFreenectDevice : public Freenect::FreenectDevice {
+// Source of Kinect frames, live or replayed.
+// Converts depth frames into vertices (or raw depth for the GPU) and hands
+// them and video frames to the renderer. Subclasses feed frames in through
+// processVideo and processDepth from their capture thread. Once a worker is
+// started, depth is converted on the worker's thread instead.
+class KinectDevice : public depth_worker::converter {
 public:
     enum DisplayMode {POINTS, TRIANGLES};
 
-    MyFreenectDevice(freenect_context *_ctx, int _index)
-    : Freenect::FreenectDevice(_ctx, _index),
-          m_buffer_video(freenect_find_video_mode(FREENECT_RESOLUTION_MEDIUM, FREENECT_VIDEO_RGB).bytes),
-          m_new_rgb_frame(false),
-          m_new_vertices(false),
-          m_display_format(TRIANGLES),
-          m_depth_frames(0)
-    {}
+    KinectDevice()
+    : m_raw_depth_output(false),
+      m_culling(CULL_GEOMETRY_SHADER),
+      m_display_format(TRIANGLES),
+      m_depth_frames(0),
+      m_video_frames(0),
+      m_unprojector(depth_tables, 2),
+      m_tiles(NULL),
+      m_filter(NULL),
+      m_hole_filler(NULL),
+      m_volume(NULL),
+      m_pool(NULL),
+      m_bands(NULL),
+      m_worker(NULL),
+      m_requested_stride(2)
+    {
+        cout << "Depth conversion kernel at stride " << m_unprojector.getStride() << ": "
+             << depth_unprojector::kernelName(m_unprojector.getKernel()) << endl;
 
-    ~MyFreenectDevice() {
-        stopVideo();
-        stopDepth();
+        // Allocate every slot up front, so handing frames to the renderer
+        // never allocates. Vertices live in the vertex stream's slots.
+        for (int i = 0; i < 3; ++i)
+        {
+            VertexFrame &frame = m_vertex_frames.slot(i);
+            frame.slot = i;
+            frame.vertices = NULL;
+            frame.count = 0;
+            frame.index_count = 0;
+            frame.stride = m_unprojector.getStride();
+            frame.capture_nanos = frame.handoff_nanos = 0;
+
+            DepthFrame &depth = m_raw_depth_frames.slot(i);
+            depth.pixels.reserve(IMG_WIDTH * IMG_HEIGHT);
+            depth.cols = depth.rows = 0;
+            depth.stride = frame.stride;
+            depth.capture_nanos = depth.handoff_nanos = 0;
+
+            RGBFrame &rgb = m_rgb_frames.slot(i);
+            rgb.pixels.resize(IMG_WIDTH * IMG_HEIGHT * PXL_SIZE);
+            rgb.data = &rgb.pixels.front();
+
+            FusedFrame &fused = m_fused_frames.slot(i);
+            fused.count = 0;
+            fused.capture_nanos = fused.handoff_nanos = 0;
+        }
     }
 
-    // Do not call directly even in child
-    void VideoCallback(void* _rgb, uint32_t timestamp) {
-        Mutex::ScopedLock lock(m_rgb_mutex);
-        uint8_t* rgb = static_cast<uint8_t*>(_rgb);
-        copy(rgb, rgb+getVideoBufferSize(), m_buffer_video.begin());
-        m_new_rgb_frame = true;
-    };
+    // Subclasses stop their capture threads first, so nothing is submitted
+    // to the worker while it stops.
+    virtual ~KinectDevice() {
+        delete m_worker;
+        delete m_bands;
+        delete m_pool;
+        delete m_volume;
+        delete m_tiles;
+        delete m_filter;
+        delete m_hole_filler;
+    }
 
-    // Do not call directly even in child
-    // Recieves a depth image for processing.
-    // Stores grayscale image in m_buffr_depth, with greater distance = darker.
-    // Stores 3d vertex for each pixel in m_vertices.
-    // Sets m_new_depth_frame and m_new_vertices to true.
-    void DepthCallback(void* _depth, uint32_t timestamp) {
-        Mutex::ScopedLock vertexLock(m_vertex_mutex);
+    virtual void startVideo() = 0;
+    virtual void startDepth() = 0;
+    virtual void stopVideo() = 0;
+    virtual void stopDepth() = 0;
+
+    // Tilt of the Kinect's motor, in degrees.
+    virtual void setTiltDegrees(double degrees) = 0;
+    virtual double getTiltDegrees() = 0;
+
+    // Skips forward, or back for negative seconds, in a recording.
+    // Live devices ignore it.
+    virtual void seekSeconds(int /*seconds*/) {}
+
+    // Never blocks.
+    // Returns true if a new rgb frame arrived since the last call.
+    // frame will point at the latest rgb frame either way, and stays
+    // valid until the next call.
+    bool getRGBframe(const RGBFrame *&frame) {
+        bool is_new = m_rgb_frames.update();
+        frame = &m_rgb_frames.front();
+        return is_new;
+    }
 
-        uint16_t* depth = static_cast<uint16_t*>(_depth);
-        kinect_depth_image img(depth);
+    // Never blocks.
+    // Returns true if a new raw depth frame arrived since the last call.
+    // frame will point at the latest raw depth either way, and stays valid
+    // until the next call.
+    bool getRawDepth(const DepthFrame *&frame) {
+        bool is_new = m_raw_depth_frames.update();
+        frame = &m_raw_depth_frames.front();
+        return is_new;
+    }
+
+    // Never blocks.
+    // Returns true if a new depth frame arrived since the last call.
+    // frame will point at the latest vertices either way, and stays valid
+    // until the next call.
+    bool getVertices(const VertexFrame *&frame) {
+        bool is_new = m_vertex_frames.update();
+        frame = &m_vertex_frames.front();
+        return is_new;
+    }
 
-        // Move last frame into m_vertices.
-        m_vertices.clear();
+    // Never blocks.
+    // Returns true if a new fused mesh arrived since the last call.
+    // frame will point at the latest fused mesh either way, and stays valid
+    // until the next call.
+    bool getFusedMesh(const FusedFrame *&frame) {
+        bool is_new = m_fused_frames.update();
+        frame = &m_fused_frames.front();
+        return is_new;
+    }
 
-        // Convert every other row and every other column into vertices.
-        for( unsigned int yy = 0 ; yy < IMG_HEIGHT ; yy+=2) {
-            for( unsigned int xx = 0 ; xx < IMG_WIDTH ; xx+=2) {
+    // Selects between publishing vertices (false) and raw depth for the
+    // GPU to unproject (true). Call before starting depth.
+    void setRawDepthOutput(bool raw) {
+        m_raw_depth_output = raw;
+    }
 
-                // Get 3d coordinates of pixel in meters
-                vec3 vertex = img.loc(xx, yy);
+    // Selects how vertices are culled after conversion. Compacted indices
+    // need slots with room for meshTriangleIndexCapacity more values.
+    // Call before starting depth.
+    void setMeshCulling(MeshCulling culling) {
+        m_culling = culling;
+    }
 
-                // Push vertex onto vertex array.
-                m_vertices.push_back( vertex.x );
-                m_vertices.push_back( vertex.y );
-                m_vertices.push_back( vertex.z );
-            }
+    // Runs depth frames through a depth_filter before anything else sees
+    // them. Call before starting depth.
+    void setDepthFilter(bool enabled) {
+        delete m_filter;
+        m_filter = NULL;
+        if (enabled)
+        {
+            m_filter = new depth_filter(IMG_WIDTH, IMG_HEIGHT, INVALID_DEPTH);
+            m_filtered.resize(IMG_WIDTH * IMG_HEIGHT);
+            cout << "Depth filter kernel: "
+                 << depth_filter::kernelName(m_filter->getKernel()) << endl;
         }
+    }
 
-        m_new_vertices = true;
-        m_depth_frames += 1;
+    // Fills small holes in depth frames after filtering, and publishes the
+    // confidence of each vertex with it. Call before starting depth.
+    void setHoleFilling(bool enabled) {
+        delete m_hole_filler;
+        m_hole_filler = NULL;
+        if (enabled)
+        {
+            m_hole_filler = new depth_hole_filler(IMG_WIDTH, IMG_HEIGHT, INVALID_DEPTH);
+            m_hole_filled.resize(IMG_WIDTH * IMG_HEIGHT);
+            m_confidence.resize(IMG_WIDTH * IMG_HEIGHT);
+            for (int i = 0; i < 3; ++i)
+                m_vertex_frames.slot(i).confidence.reserve(IMG_WIDTH * IMG_HEIGHT);
+        }
     }
 
-    // If no new rgb frame
-    //    Returns false
-    //    buffer remains unchanged.
-    //    m_new_rgb_frame remains unchanged.
-    // Otherwise
-    //    Returns true
-    //    buffer will contain rgb image acuired from Kinect.
-    //    Sets m_new_rgb_frame to false;
-    bool getRGBframe(vector<uint8_t> &buffer) {
-        Mutex::ScopedLock lock(m_rgb_mutex);
+    // Splits filtering, conversion and culling into bands of rows, and
+    // fuses, on a pool of this device's own: its depth thread and helpers
+    // more. Call before starting depth.
+    void setWorkerPool(unsigned helpers) {
+        delete m_bands;
+        delete m_pool;
+        m_pool = new parallel_for(helpers);
+        m_bands = new depth_bands(*m_pool);
+    }
 
-        if (!m_new_rgb_frame)
-            return false;
+    // Fuses depth frames into a tsdf_volume of voxel_size meter voxels and
+    // publishes its mesh instead of vertices. Call before starting depth.
+    void setFusion(float voxel_size) {
+        delete m_volume;
+        m_volume = new tsdf_volume(depth_tables, INVALID_DEPTH, voxel_size);
+    }
+
+    // Only reconverts the tiles of depth that changed by more than
+    // tolerance, see depth_tiles. The vertex stream must be created with
+    // partial updates. Call before starting depth.
+    void setDirtyTiles(unsigned tolerance) {
+        delete m_tiles;
+        m_tiles = new depth_tiles(IMG_WIDTH, IMG_HEIGHT, INVALID_DEPTH, tolerance);
+        for (int i = 0; i < 3; ++i)
+        {
+            m_stale_tiles[i].assign(m_tiles->tileCount(), 1);
+            m_vertex_frames.slot(i).upload_tiles.assign(m_tiles->tileCount(), 0);
+        }
+    }
 
-        buffer.swap(m_buffer_video);
-        m_new_rgb_frame = false;
-        return true;
+    // Converts depth frames on a thread of their own, pinned to core, see
+    // depth_worker. With wait, capture threads wait for the worker instead
+    // of dropping frames; only for sources that can wait, like recordings.
+    // name labels the thread in frame traces. Call before starting depth.
+    void startWorker(int core, const char *name, bool wait) {
+        if (!m_worker)
+            m_worker = new depth_worker(IMG_WIDTH * IMG_HEIGHT);
+        if (!m_worker->start(this, core, name, wait))
+        {
+            cerr << "Failed to start depth worker, converting on the capture thread." << endl;
+            delete m_worker;
+            m_worker = NULL;
+        }
+    }
+
+    // Stops the worker, after the frame it is converting.
+    // Call after stopping depth.
+    void stopWorker() {
+        if (m_worker)
+            m_worker->stop();
     }
 
+    // Returns the number of depth frames the worker had no time for.
+    unsigned getDroppedFrames() {
+        return m_worker ? m_worker->dropped() : 0;
+    }
 
-	// If no new depth frame
-	//    Returns false
-	//    buffer remains unchanged.
-	//    m_new_vertices remains unchanged.
-	// Otherwise
-	//    Returns true
-	//    buffer will contain 3d vertices acuired from depth image.
-	//    Sets m_new_vertices to false;
-    bool getVertices(vector<float> &buffer) {
-        Mutex::ScopedLock lock(m_vertex_mutex);
+    // Renderer: the tiles of the latest vertices have been uploaded.
+    void uploadedVertices() {
+        VertexFrame &frame = m_vertex_frames.front();
+        fill(frame.upload_tiles.begin(), frame.upload_tiles.end(), 0);
+    }
 
-        if (!m_new_vertices)
-            return false;
+    // Sets the buffer depth frames are converted into.
+    // Slots of stream must have room for a full resolution mesh.
+    void setVertexStream(vertex_stream *stream) {
+        m_vertex_stream = stream;
+    }
 
-        buffer.swap(m_vertices);
-        m_new_vertices = false;
-        return true;
+    // Sets the stride used to build vertices from following depth frames.
+    void setMeshStride(unsigned stride) {
+        m_requested_stride = stride;
     }
 
     // Returns the currently set display format.
@@ -290,6 +571,11 @@ public:
         return m_depth_frames;
     }
 
+    // Returns the number of video frames which have been published.
+    unsigned getVideoFrames() {
+        return m_video_frames;
+    }
+
     // Toggles display mode between 3d point cloud, and kinect video.
     void toggleDisplayMode() {
         if (m_display_format == TRIANGLES)
@@ -298,255 +584,1816 @@ public:
             m_display_format = TRIANGLES;
     }
 
-private:
-    vector<uint8_t>  m_buffer_video;
-    vector<float> m_vertices;
-    Mutex m_rgb_mutex;
-    Mutex m_vertex_mutex;
-    bool m_new_rgb_frame;
-    bool m_new_vertices;
-    DisplayMode m_display_format;
-    unsigned m_depth_frames;
-};
-
-
-Freenect::Freenect freenect;
-MyFreenectDevice* device;
-
-
-// This function is called every frame to track FPS statistics.
-void calculateFPS()
-{
-    // Variables used for various framerate calculations
-    static const unsigned NUM_FRAMES = 30;
-    static unsigned frames = 0;
-    static double saved_time[NUM_FRAMES] = {0};
-    static double avg_fps = 0;
-    static double max_fps = 0;
-    static double min_fps = DBL_MAX;
-    
-    // Used to access time NUM_FRAMES frames ago
-    unsigned index = frames % NUM_FRAMES;
-    
-    // Get elapsed time in seconds and record the current time
-    double curr_time = glutGet(GLUT_ELAPSED_TIME)/ 1000.0;
-    double elapsed_time = curr_time - saved_time[index];
-    saved_time[index] = curr_time;
-    
-    // Calculate current fps averaged over NUM_FRAMES frames for stability,
-    // average fps over total execution time, and min and max fps.
-    // First NUM_FRAMES frames don't yield accurate information.
-    double fps = NUM_FRAMES / elapsed_time;
-    if( frames > NUM_FRAMES - 1 ) // At least NUM_FRAMES frames have passed
-    {
-        float x = 1.0 / (frames - (NUM_FRAMES - 1)); // 1 / number of fpses in average
-        avg_fps = (1 - x) * avg_fps + x * fps; 
+protected:
+    // Publishes a copy of an IMG_WIDTH x IMG_HEIGHT rgb frame for the renderer.
+    void processVideo(const uint8_t *rgb) {
+        profile_scope scope("video copy");
+        RGBFrame &frame = m_rgb_frames.back();
+        // A plain copy, so the capture thread never waits on the pool.
+        copy(rgb, rgb + frame.pixels.size(), frame.pixels.begin());
+        frame.data = &frame.pixels.front();
+        m_rgb_frames.publish();
+        m_video_frames += 1;
+    }
 
-        if( fps > max_fps ) max_fps = fps;
-        if( fps < min_fps ) min_fps = fps;
+    // Publishes an rgb frame without copying it. rgb must stay valid for as
+    // long as the device does.
+    void shareVideo(const uint8_t *rgb) {
+        m_rgb_frames.back().data = rgb;
+        m_rgb_frames.publish();
+        m_video_frames += 1;
+    }
 
-        // Here is some console output for user
-        device->updateState();
-        cout << "\r  demanded tilt angle: " << setw(5) << freenect_angle
-             <<    " device tilt angle: "   << setw(5) << device->getState().getTiltDegs()
-             << fixed << setprecision(2)
-             << " fps: "     << setw(6) << fps
-             << " avg fps: " << setw(6) << avg_fps
-             << " min fps: " << setw(6) << min_fps
-             << " max fps: " << setw(6) << max_fps
-             << " kinect fps: " << setw(6) << device->getFrames() / curr_time;
-        cout.flush();
+    // Recieves a depth image for processing.
+    // Hands it to the worker if there is one, otherwise converts it here.
+    // capture_nanos is when the frame arrived, on frame_profiler's clock.
+    void processDepth(const uint16_t *depth, uint64_t capture_nanos) {
+        if (m_worker && m_worker->isRunning())
+            m_worker->submit(depth, capture_nanos);
+        else
+            convertDepth(depth, capture_nanos);
     }
 
-    ++frames;
-}
+private:
+    // Converts a depth image to 3d vertices and publishes them for the
+    // renderer. Frames are dropped until the renderer has set up a vertex
+    // stream. With raw depth output, publishes the sampled disparities
+    // instead.
+    void convertDepth(const uint16_t *depth, uint64_t capture_nanos) {
+        profile_scope scope("depth conversion");
+
+        // Every frame goes through the filter, so its history has no gaps.
+        if (m_filter)
+        {
+            profile_scope filter_scope("depth filter");
+            if (m_bands)
+                m_bands->filter(*m_filter, depth, &m_filtered.front());
+            else
+                m_filter->filter(depth, &m_filtered.front());
+            depth = &m_filtered.front();
+        }
 
+        if (m_hole_filler)
+        {
+            profile_scope fill_scope("hole filling");
+            m_hole_filler->fill(depth, &m_hole_filled.front(), &m_confidence.front());
+            depth = &m_hole_filled.front();
+        }
 
-// Sets up rendering parameters for kinect image vertices
-void setUpVertices(void* vertices)
-{
-    // Send vertices to the graphics card
-    glVertexPointer(3,
-                    GL_FLOAT,
-                    3*sizeof(float),
-                    vertices );
+        if (m_raw_depth_output)
+        {
+            publishRawDepth(depth, capture_nanos);
+            m_depth_frames += 1;
+            return;
+        }
 
-    glEnableClientState(GL_VERTEX_ARRAY);
-}
+        if (m_volume)
+        {
+            fuse(depth, capture_nanos);
+            m_depth_frames += 1;
+            return;
+        }
 
+        vertex_stream *stream = m_vertex_stream;
+        if (!stream)
+            return;
 
-// This function is responsible for rendering the scene every frame
-void DrawGLScene()
-{
-    // Set up buffers for images and point cloud
-    static vector<uint8_t> rgb(IMG_WIDTH * IMG_HEIGHT * PXL_SIZE);
-    static vector<float> vertices(IMG_WIDTH * IMG_HEIGHT * DIMENSIONS / 4);
+        // Pick up stride changes from the renderer.
+        unsigned stride = m_requested_stride;
+        if (m_unprojector.getStride() != stride)
+        {
+            m_unprojector.setStride(stride);
 
-    calculateFPS();
+            // Every slot holds vertices of the old stride.
+            for (int i = 0; i < 3; ++i)
+                fill(m_stale_tiles[i].begin(), m_stale_tiles[i].end(), 1);
+        }
 
-    // Start rendering. This allows libOVR to track timing information
-    // for things like predictive position tracking, which helps with rendering.
-    ovrHmd_BeginFrame(hmd, 0);
+        // Slots have room for the full resolution mesh.
+        VertexFrame &frame = m_vertex_frames.back();
+        float *out;
+        {
+            profile_scope wait_scope("vertex slot wait");
+            out = stream->beginWrite(frame.slot);
+        }
+        if (!out)
+            return; // GPU is still drawing from this slot, drop the frame.
+
+        // Convert every stride-th row and column into vertices.
+        if (m_tiles)
+            convertChangedTiles(depth, frame, out);
+        else if (m_bands)
+            m_bands->unproject(m_unprojector, depth, out);
+        else
+            m_unprojector.unproject(depth, out);
+
+        // Drop triangles across depth discontinuities, so the renderer
+        // doesn't need a geometry shader.
+        unsigned cols = m_unprojector.columns();
+        unsigned rows = m_unprojector.rowCount();
+        frame.index_count = 0;
+        if (m_culling == CULL_COMPACT_INDICES)
+        {
+            profile_scope cull_scope("triangle compaction");
+            uint32_t *indices = reinterpret_cast<uint32_t*>(out + cols * rows * DIMENSIONS);
+            if (m_bands)
+                frame.index_count = m_bands->compactTriangles(out, cols, rows, MAX_EDGE, indices);
+            else
+                frame.index_count = compactMeshTriangles(out, cols, rows, MAX_EDGE, indices);
+        }
+        else if (m_culling == CULL_NAN_VERTICES)
+        {
+            profile_scope cull_scope("vertex culling");
+            if (m_bands)
+                m_bands->markCulledVertices(out, cols, rows, MAX_EDGE);
+            else
+                markCulledMeshVertices(out, cols, rows, MAX_EDGE);
+        }
 
-    // set viewport
-    glViewport(0, 0, texture_w, texture_h);
+        if (m_hole_filler)
+            sampleConfidence(frame);
 
-    // Get the offset of each eye from center.
-    ovrVector3f hmdToEyeViewOffset[2];
-    hmdToEyeViewOffset[0] = eyeRenderDesc[0].HmdToEyeViewOffset;
-    hmdToEyeViewOffset[1] = eyeRenderDesc[1].HmdToEyeViewOffset;
+        frame.vertices = out;
+        frame.count = m_unprojector.vertexCount();
+        frame.stride = stride;
+        frame.capture_nanos = capture_nanos;
+        frame.handoff_nanos = frame_profiler::nanos();
 
-    // Position and orientation of each eye will be stored in eyePoses.
-    ovrPosef eyePoses[2];
-    ovrTrackingState hmdState;
-    ovrHmd_GetEyePoses(hmd, 0, hmdToEyeViewOffset, eyePoses, &hmdState);
+        m_vertex_frames.publish();
+        m_depth_frames += 1;
+    }
 
-    if(!(hmdState.StatusFlags & ovrStatus_PositionTracked))
-        cout << endl << "No position tracking" << endl;
+    // Converts the tiles of depth that changed since frame's slot was last
+    // written, from the tile tracker's reference image.
+    void convertChangedTiles(const uint16_t *depth, VertexFrame &frame, float *out) {
+        {
+            profile_scope scope("tile compare");
+            m_tiles->update(depth);
+        }
 
-    if(!(hmdState.StatusFlags & ovrStatus_PositionConnected))
-        cout << endl << "Position tracker not connected" << endl;
+        // A tile that changed now is stale in every slot.
+        const uint8_t *dirty = m_tiles->dirty();
+        unsigned tiles = m_tiles->tileCount();
+        for (int i = 0; i < 3; ++i)
+            for (unsigned t = 0; t < tiles; ++t)
+                m_stale_tiles[i][t] |= dirty[t];
+
+        vector<uint8_t> &stale = m_stale_tiles[frame.slot];
+        depth_tiles::meshRegions(IMG_WIDTH, IMG_HEIGHT, &stale.front(),
+                                 m_unprojector.getStride(), m_regions);
+        for (size_t i = 0; i < m_regions.size(); ++i)
+        {
+            const mesh_region &r = m_regions[i];
+            m_unprojector.unprojectRegion(m_tiles->reference(), out,
+                                          r.row_begin, r.row_end, r.col_begin, r.col_end);
+        }
 
-    // Get the geometry.
-    device->getVertices(vertices);
-    setUpVertices(&vertices.front());
+        // The renderer may have skipped earlier frames in this slot, so
+        // keep what they rewrote too.
+        for (unsigned t = 0; t < tiles; ++t)
+        {
+            frame.upload_tiles[t] |= stale[t];
+            stale[t] = 0;
+        }
+    }
 
-    // Setup the texture to place on geometry.
-    device->getRGBframe(rgb);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gl_rgb_tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, IMG_WIDTH, IMG_HEIGHT,
-                 0, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
+    // Integrates depth into the volume, and publishes the mesh if any of
+    // it changed.
+    void fuse(const uint16_t *depth, uint64_t capture_nanos) {
+        {
+            profile_scope scope("tsdf integration");
+            m_volume->integrate(depth, m_bands ? &m_bands->getPool() : NULL);
+        }
+        {
+            profile_scope scope("marching cubes");
+            if (!m_volume->extract(m_bands ? &m_bands->getPool() : NULL))
+                return;
+        }
 
+        profile_scope scope("fused mesh copy");
+        m_fused_mesh.clear();
+        m_volume->appendMesh(m_fused_mesh);
+
+        // Add video texture coordinates by projecting each vertex into the
+        // depth image.
+        FusedFrame &frame = m_fused_frames.back();
+        const unsigned in_floats = tsdf_volume::FLOATS_PER_VERTEX;
+        const unsigned out_floats = FusedFrame::FLOATS_PER_VERTEX;
+        frame.count = m_fused_mesh.size() / in_floats;
+        frame.vertices.resize(frame.count * out_floats);
+        const float *in = m_fused_mesh.empty() ? NULL : &m_fused_mesh.front();
+        float *out = frame.vertices.empty() ? NULL : &frame.vertices.front();
+        float to_pixel = 1 / depth_tables.pixelFieldOfView();
+        for (unsigned i = 0; i < frame.count; ++i, in += in_floats, out += out_floats)
+        {
+            copy(in, in + in_floats, out);
+            float x = in[0] * to_pixel / in[2] + IMG_WIDTH * 0.5f;
+            float y = IMG_HEIGHT * 0.5f - in[1] * to_pixel / in[2];
+            videoTexCoord(x, y, out[6], out[7]);
+        }
 
-    // Render the scene for each eye
-    for(int index = 0; index < ovrEye_Count; ++index)
-    {
-        ovrEyeType curr_eye = hmd->EyeRenderOrder[index];
+        frame.capture_nanos = capture_nanos;
+        frame.handoff_nanos = frame_profiler::nanos();
+        m_fused_frames.publish();
+    }
 
-        // Bind framebuffer
-        glBindFramebuffer(GL_FRAMEBUFFER, frame_buffers[curr_eye]);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Copies the confidence of every pixel that became a vertex into frame.
+    void sampleConfidence(VertexFrame &frame) {
+        unsigned stride = m_unprojector.getStride();
+        frame.confidence.resize(m_unprojector.vertexCount());
+        uint8_t *out = &frame.confidence.front();
+        for (unsigned yy = 0; yy < IMG_HEIGHT; yy += stride)
+            for (unsigned xx = 0; xx < IMG_WIDTH; xx += stride)
+                *out++ = m_confidence[yy * IMG_WIDTH + xx];
+    }
 
-        // Get a projection matrix from LibOVR.
-        Matrix4f projection = ovrMatrix4f_Projection(eyeRenderDesc[curr_eye].Fov, .01, 100, false);
-
-        // Calculate left handed up vector and forward vector for eye
-        Matrix4f view = Matrix4f(eyePoses[curr_eye].Orientation);
-        OVR::Vector3f up          = view.Transform(OVR::Vector3f(0, -1, 0));
-        OVR::Vector3f forward     = view.Transform(OVR::Vector3f(0, 0, -1));
-
-        // Get view matrix from LibOVR.
-        // Orientation + position in left handed system.
-        view = OVR::Matrix4f::LookAtLH(eyePoses[curr_eye].Position,
-                                       OVR::Vector3f(eyePoses[curr_eye].Position) + forward,
-                                       up);
-
-        // Set projection matrix.
-        glMatrixMode(GL_PROJECTION);
-        glLoadMatrixf(&projection.Transposed().M[0][0]);
-
-        // Set view matrix.
-        glMatrixMode(GL_MODELVIEW);
-        glLoadMatrixf(&view.Transposed().M[0][0]); // Camera position/orientation
-        // .5 meters from position tracking camera is a good distance to call center
-        glTranslatef(0, 0, .5);           // Move World
-                                          // Rotate World
-
-        // Draw cube (virtual room)
-        glPushMatrix();
-            // Position tracking camera is 1.2m high (0 y coordinate),
-            // virtual floor is 1.5m below 0 y, move up by difference.
-            glTranslatef(0, .3, 0);       // Move "room"
-                                          // Rotate "room"
-
-            glColor4f(0.5, 0.5, 0.5, 1.0);
-            glutSolidCube(3.8);
-        glPopMatrix();
-
-        // Draw Kinect geometry
-        glPushMatrix();
-            // Transform Kinect geometry
-            // Negate Z because image is behind
-            // Kinect is positioned .5 meters above position tracking camera,
-            // reduced by .1 meters due to angle of camera.
-            glTranslatef(-.5, .4, 1.6);    // Move geometry
-                                           // Rotate geometry
-            glScalef( 1, 1, -1);
-
-            glColor4f(1, 0, 0, 1);
-            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-
-            if (device->getDisplayMode() == MyFreenectDevice::POINTS)
+    // Copies every stride-th pixel of depth into a raw depth frame.
+    void publishRawDepth(const uint16_t *depth, uint64_t capture_nanos) {
+        unsigned stride = m_requested_stride;
+        DepthFrame &frame = m_raw_depth_frames.back();
+        frame.cols = (IMG_WIDTH + stride - 1) / stride;
+        frame.rows = (IMG_HEIGHT + stride - 1) / stride;
+        frame.stride = stride;
+        frame.pixels.resize(frame.cols * frame.rows);
+
+        uint16_t *out = &frame.pixels.front();
+        for (unsigned yy = 0; yy < IMG_HEIGHT; yy += stride)
+        {
+            const uint16_t *row = depth + yy * IMG_WIDTH;
+            if (stride == 1)
             {
-                // Draw point cloud
-                glDrawArrays( GL_POINTS, 0, IMG_WIDTH * IMG_HEIGHT/4 );
+                copy(row, row + IMG_WIDTH, out);
+                out += IMG_WIDTH;
             }
-            else if (device->getDisplayMode() == MyFreenectDevice::TRIANGLES)
+            else
             {
-                // Draw triangle strip
-                glUseProgram(hide_invalid_vertices);
-                glDrawElements( GL_TRIANGLE_STRIP, indices.size(), GL_UNSIGNED_INT, &indices.front() );
-                glUseProgram(0);
+                for (unsigned xx = 0; xx < IMG_WIDTH; xx += stride)
+                    *out++ = row[xx];
             }
+        }
 
-            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-        glPopMatrix();
+        frame.capture_nanos = capture_nanos;
+        frame.handoff_nanos = frame_profiler::nanos();
+        m_raw_depth_frames.publish();
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    // Tell LibOVR to display the rendered scene.
-    ovrHmd_EndFrame(hmd, eyePoses, &eyeTextures[0].Texture);
-}
+    bool m_raw_depth_output;
+    MeshCulling m_culling;
+    triple_buffer<RGBFrame> m_rgb_frames;
+    triple_buffer<VertexFrame> m_vertex_frames;
+    triple_buffer<DepthFrame> m_raw_depth_frames;
+    triple_buffer<FusedFrame> m_fused_frames;
+    DisplayMode m_display_format;
+    unsigned m_depth_frames;
+    unsigned m_video_frames;
+    depth_unprojector m_unprojector;
+    depth_tiles *m_tiles;                 // Dirty tile tracker, NULL converts all
+    vector<uint8_t> m_stale_tiles[3];     // Tiles each vertex slot needs reconverted
+    vector<mesh_region> m_regions;
+    depth_filter *m_filter;               // NULL leaves depth as it arrives
+    vector<uint16_t> m_filtered;          // Output of m_filter
+    depth_hole_filler *m_hole_filler;     // NULL leaves holes
+    vector<uint16_t> m_hole_filled;       // Output of m_hole_filler
+    vector<uint8_t> m_confidence;         // Confidence of m_hole_filled pixels
+    tsdf_volume *m_volume;                // NULL converts each frame on its own
+    parallel_for *m_pool;                 // This device's alone, so stages never wait on another's
+    depth_bands *m_bands;                 // Splits stages over m_pool, NULL runs them here
+    vector<float> m_fused_mesh;           // Mesh from m_volume, before texture coordinates
+    depth_worker *m_worker;               // NULL converts on the capture thread
+    OVR::AtomicInt<unsigned> m_requested_stride;
+    OVR::AtomicPtr<vertex_stream> m_vertex_stream;
+};
 
 
-// This is executed when there is no input.
-void idleFunc()
-{
-    // Written by Glenn G. Chappell
-    static int error_count = 0;
-    if (GLenum err = glGetError())
+/* Borrowed this class from cppview.cpp. Used here in a heavily modified form */
+class MyFreenectDevice : public Freenect::FreenectDevice, public KinectDevice {
+public:
+    MyFreenectDevice(freenect_context *_ctx, int _index)
+    : Freenect::FreenectDevice(_ctx, _index),
+      m_recorder(NULL),
+      m_codec(IMG_WIDTH, IMG_HEIGHT, INVALID_DEPTH)
     {
-        ++error_count;
-        std::cerr << "OpenGL ERROR " << error_count << ": "
-             << gluErrorString(err) << endl;
+        pthread_mutex_init(&m_record_lock, NULL);
     }
-    
-    glutPostRedisplay();
-}
 
+    ~MyFreenectDevice() {
+        stopVideo();
+        stopDepth();
+        pthread_mutex_destroy(&m_record_lock);
+    }
 
-// This handles keyboard keypresses.
-void keyPressed(unsigned char key, int x, int y)
-{
-    switch (key)
-    {
-        case ESC: // Shutdown program
-            glutDestroyWindow(window);
+    // Do not call directly even in child
+    void VideoCallback(void* _rgb, uint32_t timestamp) {
+        uint8_t* rgb = static_cast<uint8_t*>(_rgb);
+        frame_profiler::nameThread("libfreenect");
+        pthread_mutex_lock(&m_record_lock);
+        if (m_recorder)
+            m_recorder->write(KINECT_VIDEO_CHUNK, timestamp, rgb, getVideoBufferSize());
+        pthread_mutex_unlock(&m_record_lock);
+        processVideo(rgb);
+    };
 
-            // Clean up hmd and oculus VR library.
-            ovrHmd_Destroy(hmd);
-            ovr_Shutdown();
+    // Do not call directly even in child
+    void DepthCallback(void* _depth, uint32_t timestamp) {
+        // timestamp is on the Kinect's clock, arrival stands in for capture.
+        uint64_t capture_nanos = frame_profiler::nanos();
+        uint16_t* depth = static_cast<uint16_t*>(_depth);
+        frame_profiler::nameThread("libfreenect");
+        pthread_mutex_lock(&m_record_lock);
+        if (m_recorder)
+        {
+            // Raw depth is too much for disks over a long recording.
+            profile_scope scope("depth recording");
+            m_codec.encode(depth, m_encoded);
+            m_recorder->write(KINECT_DEPTH_CODEC_CHUNK, timestamp,
+                              &m_encoded.front(), m_encoded.size());
+        }
+        pthread_mutex_unlock(&m_record_lock);
+        processDepth(depth, capture_nanos);
+    }
 
-            cout << endl << "Finished" << endl << endl;
-            break;
-        case 'v': // Toggle display mode between point cloud and triangle strip.
-            cout << endl << endl << " Changing display mode to: ";
-            device->toggleDisplayMode();
-            if(device->getDisplayMode() == MyFreenectDevice::POINTS)
-                cout << "POINTS" << endl;
-            else if(device->getDisplayMode() == MyFreenectDevice::TRIANGLES)
-                cout << "TRIANGLES" << endl;
-            break;
+    // Writes every frame to recorder as well, NULL stops writing. Waits for
+    // a frame being written to finish, so once recording stops the recorder
+    // may be closed.
+    void setRecorder(kinect_recorder *recorder) {
+        pthread_mutex_lock(&m_record_lock);
+        m_recorder = recorder;
+        pthread_mutex_unlock(&m_record_lock);
+    }
 
-        // Change verticle tilt angle of Kinect.
-        case'w':
-            freenect_angle++;
-            if (freenect_angle > 30)
-            {
-                freenect_angle = 30;
+    void startVideo() { Freenect::FreenectDevice::startVideo(); }
+    void startDepth() { Freenect::FreenectDevice::startDepth(); }
+    void stopVideo() { Freenect::FreenectDevice::stopVideo(); }
+    void stopDepth() { Freenect::FreenectDevice::stopDepth(); }
+
+    void setTiltDegrees(double degrees) {
+        Freenect::FreenectDevice::setTiltDegrees(degrees);
+    }
+
+    double getTiltDegrees() {
+        updateState();
+        return getState().getTiltDegs();
+    }
+
+private:
+    kinect_recorder *m_recorder;          // Under m_record_lock
+    pthread_mutex_t m_record_lock;        // Held by callbacks while recording
+    depth_codec m_codec;
+    vector<uint8_t> m_encoded;  // Compressed depth frame being recorded
+};
+
+
+// Plays a recorded session back through the same pipeline as a live Kinect,
+// on its own thread. Frames come at the recorded pace, or as fast as they
+// can be processed. The recording loops until the device is stopped.
+// Frames are read in place from the memory mapped recording, only
+// compressed depth is copied, when it is decoded.
+class ReplayDevice : public KinectDevice {
+public:
+    ReplayDevice(const string &path, bool realtime)
+    : m_codec(IMG_WIDTH, IMG_HEIGHT, INVALID_DEPTH),
+      m_decoded(IMG_WIDTH * IMG_HEIGHT),
+      m_realtime(realtime), m_running(false), m_loops(0)
+    {
+        m_video_on = 0;
+        m_depth_on = 0;
+        m_stop = 0;
+        m_seek_seconds = 0;
+        if (m_archive.open(path) &&
+            (m_archive.width() != IMG_WIDTH || m_archive.height() != IMG_HEIGHT))
+        {
+            cerr << "Recording is not " << IMG_WIDTH << "x" << IMG_HEIGHT << endl;
+            m_archive.close();
+        }
+    }
+
+    ~ReplayDevice() {
+        stopVideo();
+        stopDepth();
+    }
+
+    // Returns false if the recording could not be opened.
+    bool isOpen() const {
+        return m_archive.isOpen();
+    }
+
+    void startVideo() { m_video_on = 1; startThread(); }
+    void startDepth() { m_depth_on = 1; startThread(); }
+    void stopVideo() { m_video_on = 0; stopThreadIfIdle(); }
+    void stopDepth() { m_depth_on = 0; stopThreadIfIdle(); }
+
+    // A recording has no motor.
+    void setTiltDegrees(double) {}
+    double getTiltDegrees() { return 0; }
+
+    // Picked up by the replay thread before its next frame.
+    void seekSeconds(int seconds) {
+        m_seek_seconds += seconds;
+    }
+
+    // Returns how many times the recording has played through.
+    unsigned getLoops() {
+        return m_loops;
+    }
+
+private:
+    void startThread() {
+        if (m_running || !isOpen())
+            return;
+        m_stop = 0;
+        m_running = pthread_create(&m_thread, NULL, &ReplayDevice::threadFunc, this) == 0;
+    }
+
+    void stopThreadIfIdle() {
+        if (!m_running || m_video_on || m_depth_on)
+            return;
+        m_stop = 1;
+        pthread_join(m_thread, NULL);
+        m_running = false;
+    }
+
+    static void *threadFunc(void *arg) {
+        static_cast<ReplayDevice*>(arg)->play();
+        return NULL;
+    }
+
+    // Feeds chunks to the pipeline until stopped.
+    void play() {
+        const uint32_t depth_bytes = IMG_WIDTH * IMG_HEIGHT * sizeof(uint16_t);
+        const uint32_t video_bytes = IMG_WIDTH * IMG_HEIGHT * PXL_SIZE;
+        uint64_t loop_start = kinectRecordingNanos();
+        size_t next = 0;
+
+        if (m_archive.size() == 0)
+            return; // Recording has no frames.
+
+        frame_profiler::nameThread("replay");
+
+        while (!m_stop)
+        {
+            // Jump to the requested time, keeping the pace from there. Where
+            // playback is comes from the recording, replaying as fast as
+            // possible has nothing to do with the time since it started.
+            if (int seek = m_seek_seconds.Exchange_Sync(0))
+            {
+                uint64_t current = next < m_archive.size() ? m_archive.chunk(next).nanos
+                                                           : m_archive.duration();
+                int64_t position = int64_t(current) + int64_t(seek) * 1000000000;
+                if (position < 0)
+                    position = 0;
+                next = m_archive.find(position);
+                loop_start = kinectRecordingNanos() - position;
+            }
+
+            if (next >= m_archive.size())
+            {
+                // Start over at the end of the recording.
+                next = 0;
+                m_loops += 1;
+                loop_start = kinectRecordingNanos();
+            }
+
+            const kinect_chunk &chunk = m_archive.chunk(next);
+            const uint8_t *payload = m_archive.payload(next);
+            ++next;
+
+            if (m_realtime)
+            {
+                uint64_t due = loop_start + chunk.nanos;
+                uint64_t now = kinectRecordingNanos();
+                if (due > now)
+                    usleep((due - now) / 1000);
+            }
+
+            if (!payload)
+                continue; // Truncated recording.
+            if (chunk.type == KINECT_DEPTH_CHUNK && chunk.bytes == depth_bytes && m_depth_on)
+                processDepth(reinterpret_cast<const uint16_t*>(payload), frame_profiler::nanos());
+            else if (chunk.type == KINECT_DEPTH_CODEC_CHUNK && m_depth_on)
+            {
+                uint64_t capture_nanos = frame_profiler::nanos();
+                if (m_codec.decode(payload, chunk.bytes, &m_decoded.front()))
+                    processDepth(&m_decoded.front(), capture_nanos);
+            }
+            else if (chunk.type == KINECT_VIDEO_CHUNK && chunk.bytes == video_bytes && m_video_on)
+                shareVideo(payload);
+        }
+    }
+
+    kinect_archive m_archive;
+    depth_codec m_codec;
+    vector<uint16_t> m_decoded;  // Decompressed depth, replay thread only
+    bool m_realtime;
+    bool m_running;
+    pthread_t m_thread;
+    OVR::AtomicInt<int> m_video_on;
+    OVR::AtomicInt<int> m_depth_on;
+    OVR::AtomicInt<int> m_stop;
+    OVR::AtomicInt<int> m_seek_seconds;
+    OVR::AtomicInt<unsigned> m_loops;
+};
+
+
+// Source of made up frames, for benchmarking without a Kinect or a
+// recording. Plays a short loop of synthetic depth frames, with a fixed
+// video frame, on its own thread at the Kinect's 30 frames per second or
+// as fast as they can be processed.
+class SyntheticDevice : public KinectDevice {
+public:
+    static const unsigned LOOP_FRAMES = 30;
+    static const uint64_t FRAME_NANOS = 1000000000 / 30;
+
+    SyntheticDevice(bool realtime)
+    : m_depth(LOOP_FRAMES), m_realtime(realtime), m_running(false)
+    {
+        m_video_on = 0;
+        m_depth_on = 0;
+        m_stop = 0;
+
+        // Made up front, so the depth thread only does what a Kinect's would.
+        for (unsigned i = 0; i < LOOP_FRAMES; ++i)
+            makeSyntheticDepthFrame(m_depth[i], IMG_WIDTH, IMG_HEIGHT, INVALID_DEPTH, i);
+        makeSyntheticVideoFrame(m_video, IMG_WIDTH, IMG_HEIGHT);
+    }
+
+    ~SyntheticDevice() {
+        stopVideo();
+        stopDepth();
+    }
+
+    void startVideo() { m_video_on = 1; startThread(); }
+    void startDepth() { m_depth_on = 1; startThread(); }
+    void stopVideo() { m_video_on = 0; stopThreadIfIdle(); }
+    void stopDepth() { m_depth_on = 0; stopThreadIfIdle(); }
+
+    // Synthetic frames have no motor.
+    void setTiltDegrees(double) {}
+    double getTiltDegrees() { return 0; }
+
+private:
+    void startThread() {
+        if (m_running)
+            return;
+        m_stop = 0;
+        m_running = pthread_create(&m_thread, NULL, &SyntheticDevice::threadFunc, this) == 0;
+    }
+
+    void stopThreadIfIdle() {
+        if (!m_running || m_video_on || m_depth_on)
+            return;
+        m_stop = 1;
+        pthread_join(m_thread, NULL);
+        m_running = false;
+    }
+
+    static void *threadFunc(void *arg) {
+        static_cast<SyntheticDevice*>(arg)->play();
+        return NULL;
+    }
+
+    // Feeds frames to the pipeline until stopped.
+    void play() {
+        frame_profiler::nameThread("synthetic");
+
+        uint64_t due = frame_profiler::nanos();
+        for (unsigned frame = 0; !m_stop; ++frame)
+        {
+            if (m_realtime)
+            {
+                due += FRAME_NANOS;
+                uint64_t now = frame_profiler::nanos();
+                if (due > now)
+                    usleep((due - now) / 1000);
+            }
+
+            if (m_video_on)
+                shareVideo(&m_video.front());
+            if (m_depth_on)
+                processDepth(&m_depth[frame % LOOP_FRAMES].front(), frame_profiler::nanos());
+        }
+    }
+
+    vector< vector<uint16_t> > m_depth;
+    vector<uint8_t> m_video;
+    bool m_realtime;
+    bool m_running;
+    pthread_t m_thread;
+    OVR::AtomicInt<int> m_video_on;
+    OVR::AtomicInt<int> m_depth_on;
+    OVR::AtomicInt<int> m_stop;
+};
+
+
+// A Kinect and everything the renderer keeps to draw it.
+struct KinectView {
+    KinectDevice *device;
+    Matrix4f extrinsic;             // Kinect's geometry to world, before Z is negated.
+
+    // Static parts of the Kinect mesh, rebuilt only when the stride changes.
+    GLuint vao;                     // Vertex, texture coordinate and index streams.
+    GLuint index_buffer;            // Vertex indices for triangle strips.
+    GLuint texcoord_buffer;         // Texture coordinates for every vertex.
+    GLsizei index_count;
+    unsigned drawn_stride;          // Stride indices and texCoords were built for.
+
+    vertex_stream vertices;         // GPU buffer the device writes vertices into.
+    texture_stream rgb;             // Texture Kinect video is streamed into.
+    GLuint grid_buffer;             // Column and row of every vertex, GPU unprojection only.
+    GLuint depth_tex;               // Raw disparities, one texel per vertex.
+    gpu_hole_filler holes;          // GPU hole filling only.
+    GLuint fill_confidence_tex;     // Confidence per vertex, CPU hole filling only.
+
+    // Fused mesh, fusion only.
+    GLuint fused_vao;               // Vertex, normal and texture coordinate streams.
+    GLuint fused_buffer;
+    GLsizeiptr fused_capacity;      // Bytes allocated for fused_buffer.
+    uint64_t fused_upload_bytes;
+
+    // Latest frame, set up by updateKinectView.
+    int vertex_slot;                // Slot of vertices drawn from, -1 for none
+    unsigned vertex_count;
+    GLintptr triangle_offset;       // Byte offset of compacted indices in vertices.
+    GLsizei triangle_index_count;
+
+    KinectView()
+    : device(NULL), vao(0), index_buffer(0), texcoord_buffer(0), index_count(0),
+      drawn_stride(0), grid_buffer(0), depth_tex(0), fill_confidence_tex(0),
+      fused_vao(0), fused_buffer(0), fused_capacity(0), fused_upload_bytes(0),
+      vertex_slot(-1), vertex_count(0), triangle_offset(0), triangle_index_count(0)
+    {}
+};
+
+KinectView kinect_views[MAX_KINECTS];
+kinect_recorder recorder;
+MyFreenectDevice *recording_device = NULL;  // Kinect writing to recorder
+
+
+// libfreenect context, only created when a live Kinect is used.
+Freenect::Freenect &freenectContext()
+{
+    static Freenect::Freenect freenect;
+    return freenect;
+}
+
+
+// Changes the mesh resolution. Vertices, texture coordinates and indices
+// all switch over once the first depth frame with the new stride arrives.
+void setMeshStride(unsigned stride)
+{
+    mesh_stride = stride;
+    for (int i = 0; i < kinect_count; ++i)
+        kinect_views[i].device->setMeshStride(stride);
+}
+
+
+// Returns the number of depth frames every Kinect has converted.
+unsigned totalKinectFrames()
+{
+    unsigned frames = 0;
+    for (int i = 0; i < kinect_count; ++i)
+        frames += kinect_views[i].device->getFrames();
+    return frames;
+}
+
+
+// Level of detail policy, called with the work time of every rendered
+// frame in seconds. Coarsens the mesh when the work gets close to the
+// budget, and goes back towards the user's stride when there is plenty of
+// headroom. Work time leaves out waiting for vsync, so unlike the frame
+// interval it drops when the scene gets cheaper.
+void updateLevelOfDetail(double work_time)
+{
+    // Frames to wait after a change, so the new stride shows up in the
+    // averaged work time before deciding again.
+    static const unsigned SETTLE_FRAMES = 90;
+    static const double SMOOTHING = 1.0 / 30;
+    static unsigned settle = 0;
+    static double frame_time = 0;
+
+    frame_time = frame_time > 0 ? (1 - SMOOTHING) * frame_time + SMOOTHING * work_time
+                                : work_time;
+    if (!lod_enabled || settle > 0)
+    {
+        if (settle > 0) --settle;
+        return;
+    }
+
+    // Points skip the geometry shader and most of the fill, so they are the
+    // first thing to fall back to, and the last thing to come back from.
+    // Triangles only come back with plenty of room, points are far cheaper.
+    // Halving the stride quadruples the vertices, so it needs room as well.
+    if (frame_time > FRAME_BUDGET * 0.9 && !lod_points)
+    {
+        lod_points = true;
+        scene_changed = true;
+        settle = SETTLE_FRAMES;
+    }
+    else if (frame_time > FRAME_BUDGET * 0.9 && mesh_stride < MAX_MESH_STRIDE)
+    {
+        setMeshStride(mesh_stride * 2);
+        settle = SETTLE_FRAMES;
+    }
+    else if (frame_time < FRAME_BUDGET * 0.2 && mesh_stride > user_mesh_stride)
+    {
+        setMeshStride(mesh_stride / 2);
+        settle = SETTLE_FRAMES;
+    }
+    else if (frame_time < FRAME_BUDGET * 0.25 && lod_points)
+    {
+        lod_points = false;
+        scene_changed = true;
+        settle = SETTLE_FRAMES;
+    }
+}
+
+
+// Receives Kinect latency results once a second.
+void onKinectLatency(kinect_latency_results *results)
+{
+    latest_latency = *results;
+}
+
+
+// Total latest GPU time of count sections, sections not timed count as 0.
+double gpuMillis(const int *sections, int count)
+{
+    double total = 0;
+    for (int i = 0; i < count; ++i)
+        total += max(0.0, gpu_timing.millis(sections[i]));
+    return total;
+}
+
+
+// Work of a rendered frame in seconds: the longer of the CPU's part from
+// frame_begin up to ovrHmd_EndFrame, and the GPU's latest timed sections
+// plus distortion. Neither includes waiting for vsync.
+double frameWorkTime(uint64_t frame_begin)
+{
+    double cpu_millis = (frame_profiler::nanos() - frame_begin) / 1e6;
+    double gpu_millis = max(0.0f, ovrHmd_GetFloat(hmd, OVR_KEY_GPU_DISTORTION_MS, -1));
+    for (int s = 0; s < gpu_timing.sectionCount(); ++s)
+        gpu_millis += max(0.0, gpu_timing.millis(s));
+    return max(cpu_millis, gpu_millis) / 1000;
+}
+
+
+// Puts the latest GPU timings into the frame trace, lined up with the CPU
+// timings on the CPU's clock.
+void traceGpuTimings()
+{
+    gpu_timing.calibrate(frame_profiler::nanos());
+    for (int s = 0; s < gpu_timing.sectionCount(); ++s)
+    {
+        double ms = gpu_timing.millis(s);
+        if (ms >= 0)
+            frame_profiler::recordTrack(gpu_track, gpu_timing.name(s),
+                                        gpu_timing.cpuStart(s), uint64_t(ms * 1e6));
+    }
+}
+
+
+// This function is called every frame to track FPS statistics.
+void calculateFPS()
+{
+    // Variables used for various framerate calculations
+    static const unsigned NUM_FRAMES = 30;
+    static unsigned frames = 0;
+    static double saved_time[NUM_FRAMES] = {0};
+    static double avg_fps = 0;
+    static double max_fps = 0;
+    static double min_fps = DBL_MAX;
+    
+    // Used to access time NUM_FRAMES frames ago
+    unsigned index = frames % NUM_FRAMES;
+    
+    // Get elapsed time in seconds and record the current time
+    double curr_time = glutGet(GLUT_ELAPSED_TIME)/ 1000.0;
+    double elapsed_time = curr_time - saved_time[index];
+    saved_time[index] = curr_time;
+    
+    // Calculate current fps averaged over NUM_FRAMES frames for stability,
+    // average fps over total execution time, and min and max fps.
+    // First NUM_FRAMES frames don't yield accurate information.
+    double fps = NUM_FRAMES / elapsed_time;
+    if( frames > NUM_FRAMES - 1 ) // At least NUM_FRAMES frames have passed
+    {
+        float x = 1.0 / (frames - (NUM_FRAMES - 1)); // 1 / number of fpses in average
+        avg_fps = (1 - x) * avg_fps + x * fps; 
+
+        if( fps > max_fps ) max_fps = fps;
+        if( fps < min_fps ) min_fps = fps;
+
+        // Video uploads of every Kinect.
+        unsigned rgb_uploads = 0, rgb_stalls = 0;
+        double rgb_millis = 0;
+        for (int i = 0; i < kinect_count; ++i)
+        {
+            const texture_stream &rgb = kinect_views[i].rgb;
+            rgb_uploads += rgb.uploadCount();
+            rgb_stalls += rgb.stallCount();
+            rgb_millis += rgb.averageUploadMillis() * rgb.uploadCount();
+        }
+        if (rgb_uploads > 0)
+            rgb_millis /= rgb_uploads;
+
+        // Here is some console output for user
+        cout << "\r  demanded tilt angle: " << setw(5) << freenect_angle
+             <<    " device tilt angle: "   << setw(5)
+             << kinect_views[0].device->getTiltDegrees()
+             << fixed << setprecision(2)
+             << " fps: "     << setw(6) << fps
+             << " avg fps: " << setw(6) << avg_fps
+             << " min fps: " << setw(6) << min_fps
+             << " max fps: " << setw(6) << max_fps
+             << " kinect fps: " << setw(6) << totalKinectFrames() / curr_time
+             << " mesh stride: " << mesh_stride << (lod_points ? " (points)" : "")
+             << " rendered: " << 100.0 * rendered_frames / max(rendered_frames + reused_frames, 1u)
+             << "%"
+             << " rgb uploads: " << rgb_uploads
+             << " (" << rgb_millis << " ms avg, "
+             << rgb_stalls << " stalls)"
+             << " gpu ms cube: " << gpuMillis(gpu_cube, 2)
+             << " mesh: " << gpuMillis(gpu_mesh, 2) + gpuMillis(&gpu_mesh_both, 1);
+
+        // LibOVR has no figure until its first timed distortion pass is
+        // read back, when the driver lacks timer queries, or when linked
+        // against a libovr.a built before the key was added to lib/LibOVR.
+        float distortion_millis = ovrHmd_GetFloat(hmd, OVR_KEY_GPU_DISTORTION_MS, -1);
+        if (distortion_millis >= 0)
+            cout << " distortion: " << distortion_millis;
+
+        cout << " kinect latency ms p50: " << latest_latency.capture_to_photon.p50
+             << " p99: " << latest_latency.capture_to_photon.p99
+             << " max: " << latest_latency.capture_to_photon.max;
+        cout.flush();
+    }
+
+    ++frames;
+}
+
+
+// Generate texture coordinate array for triangle strip assuming every
+// stride-th pixel is a vertex
+void generateTextureCoords(unsigned stride, vector<float> &texCoords)
+{
+    texCoords.clear();
+    for( unsigned yy = 0; yy < IMG_HEIGHT; yy+=stride ) {
+        for( unsigned xx = 0; xx < IMG_WIDTH; xx+=stride ) {
+
+            float s, t;
+            videoTexCoord(xx, yy, s, t);
+            texCoords.push_back(s);
+            texCoords.push_back(t);
+        }
+    }
+}
+
+
+// Generate index array for triangle strips assuming every stride-th pixel
+// is a vertex. Each pair of vertex rows is one strip, strips are separated
+// by RESTART_INDEX.
+void makeIndexArray(unsigned stride, vector<unsigned> &indices)
+{
+    unsigned height = (IMG_HEIGHT + stride - 1) / stride; // Vertex rows.
+    unsigned width = (IMG_WIDTH + stride - 1) / stride;   // Vertex columns.
+
+    indices.clear();
+    indices.reserve((height - 1) * (2 * width + 1));
+
+    for( unsigned yy = 0; yy < height-1; ++yy ) {
+        for( unsigned xx = 0; xx < width; ++xx ) {
+
+            // Push back vertical pairs of vertices.
+            indices.push_back(yy * width + xx);
+            indices.push_back((yy+1) * width + xx);
+        }
+
+        indices.push_back(RESTART_INDEX);
+    }
+}
+
+
+// Creates a buffer object holding data that never changes.
+GLuint makeStaticBuffer(GLenum target, GLsizeiptr bytes, const void *data)
+{
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    if (GLEW_ARB_buffer_storage)
+        glBufferStorage(target, bytes, data, 0);
+    else
+        glBufferData(target, bytes, data, GL_STATIC_DRAW);
+    return buffer;
+}
+
+
+// Generate the column and row of every vertex, for unprojecting on the GPU.
+void makeGridArray(unsigned stride, vector<GLshort> &grid)
+{
+    unsigned height = (IMG_HEIGHT + stride - 1) / stride; // Vertex rows.
+    unsigned width = (IMG_WIDTH + stride - 1) / stride;   // Vertex columns.
+
+    grid.clear();
+    grid.reserve(2 * width * height);
+    for( unsigned yy = 0; yy < height; ++yy ) {
+        for( unsigned xx = 0; xx < width; ++xx ) {
+            grid.push_back(xx);
+            grid.push_back(yy);
+        }
+    }
+}
+
+
+// Rebuild texture coordinates and indices of a view for a mesh of the
+// given stride, and set up its vao to draw it.
+// With GPU unprojection the vertices are a static grid too, and the depth
+// texture is resized to one texel per vertex.
+void rebuildMesh(KinectView &view, unsigned stride)
+{
+    vector<float> texCoords;
+    vector<unsigned> indices;
+    generateTextureCoords(stride, texCoords);
+    makeIndexArray(stride, indices);
+
+    if (!view.vao)
+        glGenVertexArrays(1, &view.vao);
+    glBindVertexArray(view.vao);
+
+    // Buffers are immutable, so replace them.
+    glDeleteBuffers(1, &view.texcoord_buffer);
+    glDeleteBuffers(1, &view.index_buffer);
+
+    view.texcoord_buffer = makeStaticBuffer(GL_ARRAY_BUFFER,
+                                            texCoords.size() * sizeof(float),
+                                            &texCoords.front());
+    glTexCoordPointer(2, GL_FLOAT, 0, 0);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Element array binding is part of the vertex array object.
+    view.index_buffer = makeStaticBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                                         indices.size() * sizeof(unsigned),
+                                         &indices.front());
+    view.index_count = indices.size();
+
+    if (gpu_unproject)
+    {
+        vector<GLshort> grid;
+        makeGridArray(stride, grid);
+
+        glDeleteBuffers(1, &view.grid_buffer);
+        view.grid_buffer = makeStaticBuffer(GL_ARRAY_BUFFER,
+                                            grid.size() * sizeof(GLshort),
+                                            &grid.front());
+        glVertexPointer(2, GL_SHORT, 0, 0);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        // Texture storage is immutable, so replace it.
+        // bindKinectTextures binds it to texture unit 1 for the vertex shader.
+        glDeleteTextures(1, &view.depth_tex);
+        glGenTextures(1, &view.depth_tex);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, view.depth_tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_R16UI,
+                       (IMG_WIDTH + stride - 1) / stride,
+                       (IMG_HEIGHT + stride - 1) / stride);
+
+        // So is the hole filled depth, on texture unit 3.
+        if (hole_filling == FILL_GPU)
+            view.holes.resize((IMG_WIDTH + stride - 1) / stride,
+                              (IMG_HEIGHT + stride - 1) / stride);
+        glActiveTexture(GL_TEXTURE0);
+
+        glUseProgram(hide_invalid_vertices);
+        glUniform1i(depth_stride_uniform, stride);
+        glUseProgram(point_sprites);
+        glUniform1i(points_stride_uniform, stride);
+        glUseProgram(0);
+    }
+
+    // Confidence of hole filled vertices, one texel per vertex, goes on
+    // texture unit 3 for the vertex shader.
+    if (hole_filling == FILL_CPU)
+    {
+        glDeleteTextures(1, &view.fill_confidence_tex);
+        glGenTextures(1, &view.fill_confidence_tex);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, view.fill_confidence_tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8,
+                       (IMG_WIDTH + stride - 1) / stride,
+                       (IMG_HEIGHT + stride - 1) / stride);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    glBindVertexArray(0);
+    view.drawn_stride = stride;
+}
+
+
+// Fills ranges with [begin, end) pairs of the floats frame rewrote in its
+// slot since the renderer last uploaded it: the vertices of its changed
+// tiles, and all of its compacted indices.
+void vertexUploadRanges(const VertexFrame *frame, vector<unsigned> &ranges)
+{
+    depth_tiles::meshRegions(IMG_WIDTH, IMG_HEIGHT, &frame->upload_tiles.front(),
+                             frame->stride, upload_regions);
+
+    unsigned cols = (IMG_WIDTH + frame->stride - 1) / frame->stride;
+    ranges.clear();
+    for (size_t i = 0; i < upload_regions.size(); ++i)
+    {
+        const mesh_region &r = upload_regions[i];
+        for (unsigned row = r.row_begin; row < r.row_end; ++row)
+        {
+            unsigned begin = (row * cols + r.col_begin) * DIMENSIONS;
+            unsigned end = (row * cols + r.col_end) * DIMENSIONS;
+            if (!ranges.empty() && ranges.back() == begin)
+                ranges.back() = end;  // Rows of full width regions join up.
+            else
+            {
+                ranges.push_back(begin);
+                ranges.push_back(end);
+            }
+        }
+    }
+
+    if (frame->index_count > 0)
+    {
+        ranges.push_back(frame->count * DIMENSIONS);
+        ranges.push_back(frame->count * DIMENSIONS + frame->index_count);
+    }
+}
+
+
+// Sets up rendering parameters for a view's kinect image vertices
+// offset is the byte offset of the vertices in the view's vertex stream.
+void setUpVertices(KinectView &view, GLintptr offset)
+{
+    // Vertices are already on the graphics card
+    glBindVertexArray(view.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, view.vertices.bufferId());
+    glVertexPointer(3,
+                    GL_FLOAT,
+                    3*sizeof(float),
+                    (const GLvoid*)offset );
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Compacted triangle indices follow the vertices in the same buffer.
+    if (mesh_culling == CULL_COMPACT_INDICES)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, view.vertices.bufferId());
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glBindVertexArray(0);
+}
+
+
+// Uploads a raw depth frame to a view's depth texture.
+void uploadDepth(KinectView &view, const DepthFrame *depth)
+{
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, view.depth_tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, depth->cols, depth->rows,
+                    GL_RED_INTEGER, GL_UNSIGNED_SHORT, &depth->pixels.front());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glActiveTexture(GL_TEXTURE0);
+    depth_upload_bytes += depth->pixels.size() * sizeof(uint16_t);
+}
+
+
+// Uploads the hole filling confidence of a frame's vertices.
+void uploadConfidence(KinectView &view, const VertexFrame *vertices)
+{
+    unsigned cols = (IMG_WIDTH + vertices->stride - 1) / vertices->stride;
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, view.fill_confidence_tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cols, vertices->count / cols,
+                    GL_RED, GL_UNSIGNED_BYTE, &vertices->confidence.front());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glActiveTexture(GL_TEXTURE0);
+    depth_upload_bytes += vertices->confidence.size();
+}
+
+
+// Uploads a view's fused mesh, growing its buffer when the mesh outgrows it.
+void uploadFusedMesh(KinectView &view, const FusedFrame *fused)
+{
+    const GLsizei stride = FusedFrame::FLOATS_PER_VERTEX * sizeof(float);
+    GLsizeiptr bytes = GLsizeiptr(fused->count) * stride;
+
+    if (!view.fused_vao)
+    {
+        glGenVertexArrays(1, &view.fused_vao);
+        glGenBuffers(1, &view.fused_buffer);
+        glBindVertexArray(view.fused_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, view.fused_buffer);
+        glVertexPointer(3, GL_FLOAT, stride, (const GLvoid*)0);
+        glNormalPointer(GL_FLOAT, stride, (const GLvoid*)(3 * sizeof(float)));
+        glTexCoordPointer(2, GL_FLOAT, stride, (const GLvoid*)(6 * sizeof(float)));
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glBindVertexArray(0);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, view.fused_buffer);
+    if (bytes > view.fused_capacity)
+    {
+        // Room to grow, so a slowly growing mesh doesn't reallocate every frame.
+        view.fused_capacity = bytes + bytes / 2;
+        glBufferData(GL_ARRAY_BUFFER, view.fused_capacity, NULL, GL_STREAM_DRAW);
+    }
+    if (bytes > 0)
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, &fused->vertices.front());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    view.fused_upload_bytes += bytes;
+}
+
+
+// Gets projection and view matrices for an eye from LibOVR.
+void getEyeMatrices(const ovrEyeRenderDesc &desc, const ovrPosef &pose,
+                    Matrix4f &projection, Matrix4f &view)
+{
+    // Get a projection matrix from LibOVR.
+    projection = ovrMatrix4f_Projection(desc.Fov, .01, 100, false);
+
+    // Calculate left handed up vector and forward vector for eye
+    Matrix4f orientation = Matrix4f(pose.Orientation);
+    OVR::Vector3f up          = orientation.Transform(OVR::Vector3f(0, -1, 0));
+    OVR::Vector3f forward     = orientation.Transform(OVR::Vector3f(0, 0, -1));
+
+    // Get view matrix from LibOVR.
+    // Orientation + position in left handed system.
+    view = OVR::Matrix4f::LookAtLH(pose.Position,
+                                   OVR::Vector3f(pose.Position) + forward,
+                                   up);
+}
+
+
+// Returns true if either eye moved or turned too far from its pose in
+// before for timewarp to hide it, see pace_frames.
+bool headMoved(const ovrPosef *now, const ovrPosef *before)
+{
+    for (int eye = 0; eye < ovrEye_Count; ++eye)
+    {
+        OVR::Posef a(now[eye]), b(before[eye]);
+        if (a.Translation.Distance(b.Translation) > MAX_REUSE_TRANSLATION ||
+            a.Rotation.Angle(b.Rotation) > MAX_REUSE_ROTATION)
+            return true;
+    }
+    return false;
+}
+
+
+// Loads an eye's matrices into the fixed function pipeline, with the world
+// moved to its center.
+void loadEyeMatrices(const Matrix4f &projection, const Matrix4f &view)
+{
+    // Set projection matrix.
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(&projection.Transposed().M[0][0]);
+
+    // Set view matrix.
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(&view.Transposed().M[0][0]); // Camera position/orientation
+    // .5 meters from position tracking camera is a good distance to call center
+    glTranslatef(0, 0, .5);           // Move World
+                                      // Rotate World
+}
+
+
+// The cube (virtual room), positions and normals interleaved in a static
+// buffer. Headless benchmarks never initialize GLUT, so it can't draw it.
+const float ROOM_SIZE = 3.8;  // meters on a side
+const int ROOM_VERTICES = 36;
+GLuint room_vao = 0;
+GLuint room_buffer = 0;
+
+// Builds the room's vertex array, faces wound counterclockwise seen from
+// outside like glutSolidCube's.
+void createRoom()
+{
+    // Normal, then two sides of the face whose cross product is the normal.
+    static const float faces[6][3][3] = {
+        {{ 1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+        {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+        {{ 0, 1, 0}, {0, 0, 1}, {1, 0, 0}},
+        {{ 0,-1, 0}, {1, 0, 0}, {0, 0, 1}},
+        {{ 0, 0, 1}, {1, 0, 0}, {0, 1, 0}},
+        {{ 0, 0,-1}, {0, 1, 0}, {1, 0, 0}},
+    };
+    static const float corners[6][2] = {{-1,-1}, {1,-1}, {1,1}, {-1,-1}, {1,1}, {-1,1}};
+
+    const float half = ROOM_SIZE / 2;
+    vector<float> vertices;
+    for (int f = 0; f < 6; ++f)
+    {
+        const float *normal = faces[f][0], *u = faces[f][1], *v = faces[f][2];
+        for (int c = 0; c < 6; ++c)
+        {
+            for (int k = 0; k < 3; ++k)
+                vertices.push_back(half * (normal[k] + corners[c][0] * u[k] +
+                                           corners[c][1] * v[k]));
+            vertices.insert(vertices.end(), normal, normal + 3);
+        }
+    }
+
+    glGenVertexArrays(1, &room_vao);
+    glBindVertexArray(room_vao);
+    room_buffer = makeStaticBuffer(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
+                                   &vertices.front());
+    glVertexPointer(3, GL_FLOAT, 6 * sizeof(float), 0);
+    glNormalPointer(GL_FLOAT, 6 * sizeof(float), (const GLvoid*)(3 * sizeof(float)));
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+
+// Draws the cube (virtual room) with the loaded matrices.
+void drawRoom()
+{
+    glPushMatrix();
+        // Position tracking camera is 1.2m high (0 y coordinate),
+        // virtual floor is 1.5m below 0 y, move up by difference.
+        glTranslatef(0, .3, 0);       // Move "room"
+                                      // Rotate "room"
+
+        glColor4f(0.5, 0.5, 0.5, 1.0);
+        glBindVertexArray(room_vao);
+        glDrawArrays(GL_TRIANGLES, 0, ROOM_VERTICES);
+        glBindVertexArray(0);
+    glPopMatrix();
+}
+
+
+// Transform of a Kinect's geometry into the world.
+// .5 meters from position tracking camera is a good distance to call center.
+// Negate Z because image is behind
+// The default extrinsic puts the Kinect .5 meters above the position
+// tracking camera, reduced by .1 meters due to angle of camera.
+Matrix4f kinectModel(const KinectView &view)
+{
+    return Matrix4f::Translation(0, 0, .5) *  // Move World
+           view.extrinsic *                   // Move and rotate geometry
+           Matrix4f::Scaling(1, 1, -1);
+}
+
+
+// Binds a view's video, depth and hole filling textures to the texture
+// units the shaders read them from.
+void bindKinectTextures(const KinectView &view)
+{
+    if (gpu_unproject)
+    {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, view.depth_tex);
+    }
+    if (hole_filling != FILL_NONE)
+    {
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, hole_filling == FILL_GPU ? view.holes.filledTexture()
+                                                              : view.fill_confidence_tex);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, view.rgb.textureId());
+}
+
+
+// Sprite pixels per meter of depth at a clip w of 1, for an eye with this
+// projection. A sprite covers point_size depth samples of a Kinect mesh
+// drawn with stride, which spread apart linearly with depth.
+float pointScale(const Matrix4f &projection, unsigned stride)
+{
+    float meters_per_depth = point_size * stride * depth_tables.pixelFieldOfView();
+    return meters_per_depth * projection.M[1][1] * texture_h * 0.5f;
+}
+
+
+// Draws a Kinect's vertices as point sprites once per eye in mvp, as
+// instances of one draw call, like drawKinectMesh. point_scale is
+// pointScale for each eye.
+void drawKinectPoints(const KinectView &view, const Matrix4f *mvp,
+                      const float *point_scale, int eyes)
+{
+    glUseProgram(point_sprites);
+    // LibOVR matrices are row major.
+    glUniformMatrix4fv(points_eye_mvp_uniform, eyes, GL_TRUE, &mvp[0].M[0][0]);
+    glUniform1fv(point_scale_uniform, eyes, point_scale);
+    glUniform1i(points_side_by_side_uniform, eyes > 1);
+    if (eyes > 1)
+        glEnable(GL_CLIP_DISTANCE0);
+    glEnable(GL_PROGRAM_POINT_SIZE);
+
+    bindKinectTextures(view);
+    glBindVertexArray(view.vao);
+    glDrawArraysInstanced( GL_POINTS, 0, view.vertex_count, eyes );
+    glBindVertexArray(0);
+
+    glDisable(GL_PROGRAM_POINT_SIZE);
+    glDisable(GL_CLIP_DISTANCE0);
+    glUseProgram(0);
+}
+
+
+// Draws a Kinect's fused mesh with the loaded matrices, lit and textured
+// with its video.
+void drawFusedMesh(const KinectView &view)
+{
+    // Fixed function matrices are column major.
+    Matrix4f extrinsic = view.extrinsic.Transposed();
+
+    glPushMatrix();
+        // Transform Kinect geometry, see kinectModel.
+        glMultMatrixf(&extrinsic.M[0][0]);  // Move and rotate geometry
+        glScalef( 1, 1, -1);
+
+        glColor4f(1, 1, 1, 1);
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, view.rgb.textureId());
+        glBindVertexArray(view.fused_vao);
+        glDrawArrays( GL_TRIANGLES, 0, view.vertex_count );
+        glBindVertexArray(0);
+        glDisable(GL_TEXTURE_2D);
+    glPopMatrix();
+}
+
+
+// Draws a Kinect's triangle mesh once per eye in mvp, as instances of
+// one draw call. With more than one eye, instance i is squeezed into the
+// i-th half of the side by side render target.
+void drawKinectMesh(const KinectView &view, const Matrix4f *mvp, int eyes)
+{
+    glUseProgram(hide_invalid_vertices);
+    // LibOVR matrices are row major.
+    glUniformMatrix4fv(eye_mvp_uniform, eyes, GL_TRUE, &mvp[0].M[0][0]);
+    glUniform1i(side_by_side_uniform, eyes > 1);
+    if (eyes > 1)
+        glEnable(GL_CLIP_DISTANCE0);
+
+    bindKinectTextures(view);
+    glBindVertexArray(view.vao);
+    if (mesh_culling == CULL_COMPACT_INDICES)
+    {
+        glDrawElementsInstanced( GL_TRIANGLES, view.triangle_index_count, GL_UNSIGNED_INT,
+                                 (const GLvoid*)view.triangle_offset, eyes );
+    }
+    else
+    {
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(RESTART_INDEX);
+        glDrawElementsInstanced( GL_TRIANGLE_STRIP, view.index_count, GL_UNSIGNED_INT, 0, eyes );
+        glDisable(GL_PRIMITIVE_RESTART);
+    }
+    glBindVertexArray(0);
+
+    glDisable(GL_CLIP_DISTANCE0);
+    glUseProgram(0);
+}
+
+
+// Takes a view's latest geometry from its device, and uploads what the GPU
+// does not have yet. Returns true if it is a new depth frame, with when the
+// frame was captured and handed off.
+bool updateKinectGeometry(KinectView &view, uint64_t &capture_nanos, uint64_t &handoff_nanos)
+{
+    KinectDevice *device = view.device;
+    if (fuse_depth)
+    {
+        const FusedFrame *fused = NULL;
+        bool new_mesh = device->getFusedMesh(fused);
+        if (new_mesh)
+            uploadFusedMesh(view, fused);
+        view.vertex_count = fused->count;
+        capture_nanos = fused->capture_nanos;
+        handoff_nanos = fused->handoff_nanos;
+        return new_mesh;
+    }
+
+    if (gpu_unproject)
+    {
+        const DepthFrame *depth = NULL;
+        bool new_depth = device->getRawDepth(depth);
+
+        // Rebuild the grid and depth texture when the depth changes resolution.
+        if (depth->stride != view.drawn_stride)
+            rebuildMesh(view, depth->stride);
+
+        if (new_depth && depth->cols > 0)
+            uploadDepth(view, depth);
+        view.vertex_count = depth->cols * depth->rows;
+        capture_nanos = depth->capture_nanos;
+        handoff_nanos = depth->handoff_nanos;
+        return new_depth;
+    }
+
+    view.vertices.retire();
+    const VertexFrame *vertices = NULL;
+    bool new_vertices = device->getVertices(vertices);
+
+    // Rebuild the rest of the mesh when the vertices change resolution.
+    if (vertices->stride != view.drawn_stride)
+        rebuildMesh(view, vertices->stride);
+
+    // With dirty tiles only the rewritten vertices go to the GPU.
+    const vector<unsigned> *ranges = NULL;
+    if (new_vertices && dirty_tile_tolerance >= 0)
+    {
+        vertexUploadRanges(vertices, upload_ranges);
+        ranges = &upload_ranges;
+    }
+
+    GLintptr offset = view.vertices.use(vertices->slot,
+                                        vertices->count * DIMENSIONS +
+                                        vertices->index_count,
+                                        new_vertices, ranges);
+    if (ranges)
+        device->uploadedVertices();
+    if (new_vertices && hole_filling == FILL_CPU && vertices->count > 0)
+        uploadConfidence(view, vertices);
+    setUpVertices(view, offset);
+    view.vertex_slot = vertices->slot;
+    view.vertex_count = vertices->count;
+    view.triangle_offset = offset + vertices->count * DIMENSIONS * sizeof(float);
+    view.triangle_index_count = vertices->index_count;
+    capture_nanos = vertices->capture_nanos;
+    handoff_nanos = vertices->handoff_nanos;
+    return new_vertices;
+}
+
+
+// This function is responsible for rendering the scene every frame
+void DrawGLScene()
+{
+    // Set for each Kinect with a new depth frame drawn, for measuring its latency.
+    bool new_frame[MAX_KINECTS];
+    uint64_t capture_nanos[MAX_KINECTS];
+    uint64_t handoff_nanos[MAX_KINECTS];
+
+    // Benchmarks write their own report.
+    if (!bench_frames)
+        calculateFPS();
+    frame_profiler::nameThread("render");
+    profile_scope frame_scope("frame");
+    uint64_t frame_nanos = frame_profiler::nanos();
+
+    // Start rendering. This allows libOVR to track timing information
+    // for things like predictive position tracking, which helps with rendering.
+    // Benchmarks have no distortion rendering to begin.
+    if (!bench_frames)
+        ovrHmd_BeginFrame(hmd, 0);
+    if (gpu_timing.beginFrame())
+        traceGpuTimings();
+
+    // Get the offset of each eye from center.
+    ovrVector3f hmdToEyeViewOffset[2];
+    hmdToEyeViewOffset[0] = eyeRenderDesc[0].HmdToEyeViewOffset;
+    hmdToEyeViewOffset[1] = eyeRenderDesc[1].HmdToEyeViewOffset;
+
+    // Position and orientation of each eye will be stored in eyePoses.
+    ovrPosef eyePoses[2];
+    ovrTrackingState hmdState;
+    ovrHmd_GetEyePoses(hmd, 0, hmdToEyeViewOffset, eyePoses, &hmdState);
+
+    // A debug HMD is never tracked.
+    if(!bench_frames && !(hmdState.StatusFlags & ovrStatus_PositionTracked))
+        cout << endl << "No position tracking" << endl;
+
+    if(!bench_frames && !(hmdState.StatusFlags & ovrStatus_PositionConnected))
+        cout << endl << "Position tracker not connected" << endl;
+
+    // Get the geometry of every Kinect.
+    {
+        profile_scope scope("vertex handoff");
+        bool any_new = false;
+        for (int i = 0; i < kinect_count; ++i)
+        {
+            new_frame[i] = updateKinectGeometry(kinect_views[i], capture_nanos[i],
+                                                handoff_nanos[i]);
+            any_new = any_new || new_frame[i];
+        }
+        if (any_new)
+            scene_changed = true;
+
+        // Fill holes in new depth, all Kinects timed together.
+        if (hole_filling == FILL_GPU && any_new)
+        {
+            gpu_timing.begin(gpu_hole_fill);
+            for (int i = 0; i < kinect_count; ++i)
+                if (new_frame[i] && kinect_views[i].vertex_count > 0)
+                    kinect_views[i].holes.fill(kinect_views[i].depth_tex);
+            gpu_timing.end(gpu_hole_fill);
+        }
+    }
+
+    uint64_t render_nanos = frame_profiler::nanos();
+
+    // Setup the textures to place on geometry.
+    // Only a new video frame needs uploading.
+    glActiveTexture(GL_TEXTURE0);
+    for (int i = 0; i < kinect_count; ++i)
+    {
+        const RGBFrame *rgb = NULL;
+        if (kinect_views[i].device->getRGBframe(rgb))
+        {
+            profile_scope scope("rgb upload");
+            kinect_views[i].rgb.upload(rgb->data);
+            scene_changed = true;
+        }
+    }
+
+    if (pace_frames && !scene_changed && !headMoved(eyePoses, rendered_poses))
+    {
+        reused_frames += 1;
+        gpu_timing.endFrame();
+        if (!bench_frames)
+        {
+            profile_scope scope("ovrHmd_EndFrame");
+            ovrHmd_EndFrame(hmd, rendered_poses, &eyeTextures[0].Texture);
+        }
+        return;
+    }
+    scene_changed = false;
+    rendered_frames += 1;
+    rendered_poses[0] = eyePoses[0];
+    rendered_poses[1] = eyePoses[1];
+
+    // Projection and view matrices for each eye.
+    Matrix4f projection[2];
+    Matrix4f view[2];
+    for(int eye = 0; eye < ovrEye_Count; ++eye)
+        getEyeMatrices(eyeRenderDesc[eye], eyePoses[eye], projection[eye], view[eye]);
+
+    // A fused mesh is drawn in either display mode. Level of detail may
+    // draw points in place of triangles.
+    bool draw_mesh[MAX_KINECTS];
+    bool draw_points[MAX_KINECTS];
+    bool draw_fused[MAX_KINECTS];
+    for (int i = 0; i < kinect_count; ++i)
+    {
+        const KinectView &kinect = kinect_views[i];
+        KinectDevice::DisplayMode mode = kinect.device->getDisplayMode();
+        draw_fused[i] = kinect.vertex_count > 0 && fuse_depth;
+        bool points = mode == KinectDevice::POINTS || lod_points;
+        draw_mesh[i] = kinect.vertex_count > 0 && !fuse_depth && !points;
+        draw_points[i] = kinect.vertex_count > 0 && !fuse_depth && points;
+    }
+
+    if (single_pass_stereo)
+    {
+        profile_scope scope("render both eyes");
+
+        // Both eyes share one side by side render target.
+        glBindFramebuffer(GL_FRAMEBUFFER, frame_buffers[0]);
+        glViewport(0, 0, 2 * texture_w, texture_h);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // The room and fused meshes are drawn into each eye's half.
+        for(int eye = 0; eye < ovrEye_Count; ++eye)
+        {
+            glViewport(eye * texture_w, 0, texture_w, texture_h);
+            loadEyeMatrices(projection[eye], view[eye]);
+            gpu_timing.begin(gpu_cube[eye]);
+            drawRoom();
+            gpu_timing.end(gpu_cube[eye]);
+
+            if (fuse_depth)
+            {
+                gpu_timing.begin(gpu_mesh[eye]);
+                for (int i = 0; i < kinect_count; ++i)
+                    if (draw_fused[i])
+                        drawFusedMesh(kinect_views[i]);
+                gpu_timing.end(gpu_mesh[eye]);
+            }
+        }
+
+        // Each mesh or point cloud is drawn once, instanced for both eyes.
+        glViewport(0, 0, 2 * texture_w, texture_h);
+        gpu_timing.begin(gpu_mesh_both);
+        for (int i = 0; i < kinect_count; ++i)
+        {
+            if (!draw_mesh[i] && !draw_points[i])
+                continue;
+            Matrix4f kinect_model = kinectModel(kinect_views[i]);
+            Matrix4f mvp[2];
+            float point_scale[2];
+            for(int eye = 0; eye < ovrEye_Count; ++eye)
+            {
+                mvp[eye] = projection[eye] * view[eye] * kinect_model;
+                point_scale[eye] = pointScale(projection[eye], kinect_views[i].drawn_stride);
+            }
+            if (draw_points[i])
+                drawKinectPoints(kinect_views[i], mvp, point_scale, ovrEye_Count);
+            else
+                drawKinectMesh(kinect_views[i], mvp, ovrEye_Count);
+        }
+        gpu_timing.end(gpu_mesh_both);
+    }
+    else
+    {
+        // Render the scene for each eye
+        for(int index = 0; index < ovrEye_Count; ++index)
+        {
+            ovrEyeType curr_eye = hmd->EyeRenderOrder[index];
+            profile_scope scope(curr_eye == ovrEye_Left ? "render left eye" : "render right eye");
+
+            // Bind framebuffer
+            glBindFramebuffer(GL_FRAMEBUFFER, frame_buffers[curr_eye]);
+            glViewport(0, 0, texture_w, texture_h);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            loadEyeMatrices(projection[curr_eye], view[curr_eye]);
+            gpu_timing.begin(gpu_cube[curr_eye]);
+            drawRoom();
+            gpu_timing.end(gpu_cube[curr_eye]);
+
+            // Every Kinect's mesh or points in one pass over the eye's target.
+            gpu_timing.begin(gpu_mesh[curr_eye]);
+            for (int i = 0; i < kinect_count; ++i)
+            {
+                if (draw_fused[i])
+                    drawFusedMesh(kinect_views[i]);
+                if (!draw_mesh[i] && !draw_points[i])
+                    continue;
+                Matrix4f mvp = projection[curr_eye] * view[curr_eye] *
+                               kinectModel(kinect_views[i]);
+                float point_scale = pointScale(projection[curr_eye], kinect_views[i].drawn_stride);
+                if (draw_points[i])
+                    drawKinectPoints(kinect_views[i], &mvp, &point_scale, 1);
+                else
+                    drawKinectMesh(kinect_views[i], &mvp, 1);
+            }
+            gpu_timing.end(gpu_mesh[curr_eye]);
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Depth threads may reuse these slots once the GPU is done drawing them.
+    for (int i = 0; i < kinect_count; ++i)
+        if (kinect_views[i].vertex_slot >= 0)
+            kinect_views[i].vertices.fence(kinect_views[i].vertex_slot);
+
+    gpu_timing.endFrame();
+
+    if (bench_frames)
+    {
+        // Nothing to display. Wait for the GPU instead, so every frame's
+        // time includes rendering it.
+        profile_scope scope("glFinish");
+        glFinish();
+    }
+    else
+    {
+        updateLevelOfDetail(frameWorkTime(frame_nanos));
+
+        // Tell LibOVR to display the rendered scene.
+        profile_scope scope("ovrHmd_EndFrame");
+        ovrHmd_EndFrame(hmd, eyePoses, &eyeTextures[0].Texture);
+    }
+
+    uint64_t photon_nanos = frame_profiler::nanos();
+    for (int i = 0; i < kinect_count; ++i)
+        if (new_frame[i] && capture_nanos[i])
+            kinect_latency->addFrame(capture_nanos[i], handoff_nanos[i], render_nanos,
+                                     photon_nanos);
+}
+
+
+// Stops every Kinect's streams and depth worker, and finishes the
+// recording once no callback is writing to it.
+void stopKinects()
+{
+    for (int i = 0; i < kinect_count; ++i)
+    {
+        kinect_views[i].device->stopDepth();
+        kinect_views[i].device->stopVideo();
+        kinect_views[i].device->stopWorker();
+    }
+    if (recording_device)
+    {
+        recording_device->setRecorder(NULL);
+        recording_device = NULL;
+    }
+    recorder.close();
+}
+
+
+// With frame pacing, returns true when a display has something to show:
+// the scene changed, a Kinect sent a frame since the last one, or the next
+// refresh is due with a new head pose for timewarp.
+bool displayDue()
+{
+    static unsigned shown_frames = 0;
+    static uint64_t shown_nanos = 0;
+
+    unsigned frames = totalKinectFrames();
+    for (int i = 0; i < kinect_count; ++i)
+        frames += kinect_views[i].device->getVideoFrames();
+    uint64_t now = frame_profiler::nanos();
+    if (!scene_changed && frames == shown_frames &&
+        now - shown_nanos < FRAME_BUDGET * 1e9)
+        return false;
+
+    shown_frames = frames;
+    shown_nanos = now;
+    return true;
+}
+
+
+// This is executed when there is no input.
+void idleFunc()
+{
+    // Written by Glenn G. Chappell
+    static int error_count = 0;
+    if (GLenum err = glGetError())
+    {
+        ++error_count;
+        std::cerr << "OpenGL ERROR " << error_count << ": "
+             << gluErrorString(err) << endl;
+    }
+
+    // Nothing new to show yet, wait rather than spin on reused frames.
+    if (pace_frames && !displayDue())
+    {
+        usleep(1000);
+        return;
+    }
+    glutPostRedisplay();
+}
+
+
+// Writes the stage timings of recent frames as a Chrome trace.
+void writeTrace()
+{
+    if (frame_profiler::writeChromeTrace(trace_path.c_str()))
+        cout << endl << endl << " Wrote frame trace to " << trace_path << endl;
+    else
+        cerr << endl << endl << " Failed to write frame trace to " << trace_path << endl;
+}
+
+
+// This handles keyboard keypresses.
+void keyPressed(unsigned char key, int x, int y)
+{
+    // Keys change what is drawn, show it right away.
+    scene_changed = true;
+
+    switch (key)
+    {
+        case ESC: // Shutdown program
+            stopKinects();
+            glutDestroyWindow(window);
+
+            // Clean up hmd and oculus VR library.
+            ovrHmd_Destroy(hmd);
+            ovr_Shutdown();
+
+            cout << endl << "Finished" << endl << endl;
+            break;
+        case 'v': // Toggle display mode between point cloud and triangle strip.
+            cout << endl << endl << " Changing display mode to: ";
+            for (int i = 0; i < kinect_count; ++i)
+                kinect_views[i].device->toggleDisplayMode();
+            if(kinect_views[0].device->getDisplayMode() == KinectDevice::POINTS)
+                cout << "POINTS" << endl;
+            else if(kinect_views[0].device->getDisplayMode() == KinectDevice::TRIANGLES)
+                cout << "TRIANGLES" << endl;
+            break;
+
+        // Change mesh resolution.
+        case '1':
+        case '2':
+        case '4':
+        case '8':
+            user_mesh_stride = key - '0';
+            setMeshStride(user_mesh_stride);
+            cout << endl << endl << " Changing mesh stride to: " << user_mesh_stride << endl;
+            break;
+        case 'l': // Toggle level of detail policy.
+            lod_enabled = !lod_enabled;
+            cout << endl << endl << " Level of detail: " << (lod_enabled ? "ON" : "OFF") << endl;
+            if (!lod_enabled)
+            {
+                setMeshStride(user_mesh_stride);
+                lod_points = false;
+            }
+            break;
+
+        // Change verticle tilt angle of Kinect.
+        case'w':
+            freenect_angle++;
+            if (freenect_angle > 30)
+            {
+                freenect_angle = 30;
             }
             break;
         case 's':
@@ -566,10 +2413,25 @@ void keyPressed(unsigned char key, int x, int y)
         case 'c':
             freenect_angle = -10;
             break;
+
+        case 'p': // Save recent stage timings.
+            writeTrace();
+            break;
+
+        // Scrub through replayed recordings.
+        case '[':
+            for (int i = 0; i < kinect_count; ++i)
+                kinect_views[i].device->seekSeconds(-5);
+            break;
+        case ']':
+            for (int i = 0; i < kinect_count; ++i)
+                kinect_views[i].device->seekSeconds(5);
+            break;
         default: ;
     }
 
-    device->setTiltDegrees(freenect_angle);
+    for (int i = 0; i < kinect_count; ++i)
+        kinect_views[i].device->setTiltDegrees(freenect_angle);
 }
 
 
@@ -590,20 +2452,34 @@ void mouseMove(int x, int y)
 }
 
 
-// Generate texture coordinate array for triangle strip assuming every pixel is a vertex
-void generateTextureCoords()
+// Sets the uniforms that never change of a program drawing Kinect vertices,
+// with vertex shader invalids_v.glsl or depth_v.glsl. cull_edges drops
+// vertices ending a long edge with GPU unprojection and --cull nan.
+void setUpKinectProgram(GLuint program, bool cull_edges)
 {
-    const float fovCorrection = .92185;
-    const float offset = (1 - fovCorrection) / 2;
-    for( unsigned yy = 0; yy < IMG_HEIGHT; yy+=2 ) {
-        for( unsigned xx = 0; xx < IMG_WIDTH; xx+=2 ) {
+    glUseProgram(program);
 
-            texCoords.push_back(float(xx) / IMG_WIDTH * fovCorrection + offset);
-            texCoords.push_back(float(yy) / IMG_HEIGHT * fovCorrection + 1.5 * offset);
-        }
-    }
+    // Hole filling reads texture unit 3: confidence from the depth thread,
+    // or depth filled on the GPU.
+    glUniform1i(glGetUniformLocation(program, "fill_holes"), hole_filling != FILL_NONE);
+    glUniform1i(glGetUniformLocation(program,
+                                     gpu_unproject ? "filled_depth" : "fill_confidence"), 3);
 
-    glTexCoordPointer(2, GL_FLOAT, 0, &texCoords.front());
+    if (gpu_unproject)
+    {
+        // Depth is on texture unit 1, the meters table on unit 2.
+        glUniform1i(glGetUniformLocation(program, "depth_image"), 1);
+        glUniform1i(glGetUniformLocation(program, "depth_meters"), 2);
+        glUniform2f(glGetUniformLocation(program, "image_center"),
+                    IMG_WIDTH * 0.5, IMG_HEIGHT * 0.5);
+        glUniform1f(glGetUniformLocation(program, "pixel_fov"),
+                    depth_tables.pixelFieldOfView());
+        glUniform1i(glGetUniformLocation(program, "cull_vertices"), cull_edges);
+        glUniform1f(glGetUniformLocation(program, "max_edge"), MAX_EDGE);
+        glUniform1f(glGetUniformLocation(program, "not_a_number"),
+                    std::numeric_limits<float>::quiet_NaN());
+    }
+    glUseProgram(0);
 }
 
 
@@ -615,63 +2491,169 @@ void InitGL(unsigned int tex_w, unsigned int tex_h)
 
     // Compile shaders into a program.
     glewInit();
-    string vShader = "shaders/invalids_v.glsl";
+    string vShader = gpu_unproject ? "shaders/depth_v.glsl" : "shaders/invalids_v.glsl";
     string gShader = "shaders/normals_g.glsl";
     string fShader = "shaders/invalids_f.glsl";    
-    hide_invalid_vertices = makeShaderProgramFromFiles(vShader, gShader, fShader);
+    if (mesh_culling == CULL_GEOMETRY_SHADER)
+        hide_invalid_vertices = makeShaderProgramFromFiles(vShader, gShader, fShader);
+    else
+        hide_invalid_vertices = makeShaderProgramFromFiles(vShader, fShader);
+    eye_mvp_uniform = glGetUniformLocation(hide_invalid_vertices, "eye_mvp");
+    side_by_side_uniform = glGetUniformLocation(hide_invalid_vertices, "side_by_side");
+    depth_stride_uniform = glGetUniformLocation(hide_invalid_vertices, "stride");
+    setUpKinectProgram(hide_invalid_vertices, mesh_culling == CULL_NAN_VERTICES);
+
+    // Points have nothing to cull but vertices without depth, which are
+    // moved out of view if cull_invalid_points.
+    point_sprites = makeShaderProgramFromFiles(vShader, "shaders/points_f.glsl");
+    points_eye_mvp_uniform = glGetUniformLocation(point_sprites, "eye_mvp");
+    points_side_by_side_uniform = glGetUniformLocation(point_sprites, "side_by_side");
+    point_scale_uniform = glGetUniformLocation(point_sprites, "point_scale");
+    points_stride_uniform = glGetUniformLocation(point_sprites, "stride");
+    setUpKinectProgram(point_sprites, false);
+    glUseProgram(point_sprites);
+    glUniform1i(glGetUniformLocation(point_sprites, "cull_points"), cull_invalid_points);
+    glUseProgram(0);
+    if (hole_filling == FILL_GPU)
+    {
+        // Every Kinect has its own textures, the programs are shared.
+        GLuint pull = makeShaderProgramFromFiles("shaders/fullscreen_v.glsl",
+                                                 "shaders/hole_pull_f.glsl");
+        GLuint push = makeShaderProgramFromFiles("shaders/fullscreen_v.glsl",
+                                                 "shaders/hole_push_f.glsl");
+        for (int i = 0; i < kinect_count; ++i)
+            kinect_views[i].holes.create(pull, push, INVALID_DEPTH);
+    }
+
+    if (gpu_unproject)
+    {
+        // The meters table never changes, upload it once.
+        glActiveTexture(GL_TEXTURE2);
+        glGenTextures(1, &gl_depth_meters_tex);
+        glBindTexture(GL_TEXTURE_2D, gl_depth_meters_tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32F, kinect_depth_tables::DISPARITY_LEVELS, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, kinect_depth_tables::DISPARITY_LEVELS, 1,
+                        GL_RED, GL_FLOAT, depth_tables.metersTable());
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // Create a texture for coloring each Kinect's geometry.
+    for (int i = 0; i < kinect_count; ++i)
+    {
+        kinect_views[i].rgb.create(IMG_WIDTH, IMG_HEIGHT, GL_RGBA8, GL_RGB, 3);
+        rebuildMesh(kinect_views[i], mesh_stride);
+    }
 
-    // Create a texture for coloring Kinect geometry.
-    glGenTextures(1, &gl_rgb_tex);
-    glBindTexture(GL_TEXTURE_2D, gl_rgb_tex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    generateTextureCoords();
+    // Time render passes on the GPU.
+    gpu_cube[ovrEye_Left] = gpu_timing.addSection("cube left eye");
+    gpu_cube[ovrEye_Right] = gpu_timing.addSection("cube right eye");
+    gpu_mesh[ovrEye_Left] = gpu_timing.addSection("mesh left eye");
+    gpu_mesh[ovrEye_Right] = gpu_timing.addSection("mesh right eye");
+    gpu_mesh_both = gpu_timing.addSection("mesh both eyes");
+    gpu_hole_fill = gpu_timing.addSection("hole filling");
+    gpu_timing.create();
+    gpu_track = frame_profiler::addTrack("gpu");
+
+    // Measure Kinect frame latency.
+    kinect_latency = new kinect_latency_calculator;
+    kinect_latency_observer = new OVR::ObserverScope<kinect_latency_slot>;
+    kinect_latency_observer->SetHandler(kinect_latency_slot::FromFree<&onKinectLatency>());
+    kinect_latency->addResultsObserver(kinect_latency_observer);
+
+    if (gpu_unproject)
+    {
+        cout << "Kinect vertices: unprojected on GPU" << endl;
+    }
+    else if (fuse_depth)
+    {
+        cout << "Kinect vertices: fused, " << fusion_voxel_size * 100 << " cm voxels" << endl;
+    }
+    else
+    {
+        // Create the buffers the depth threads write vertices into,
+        // followed by triangle indices when they are compacted.
+        unsigned slot_floats = IMG_WIDTH * IMG_HEIGHT * DIMENSIONS;
+        if (mesh_culling == CULL_COMPACT_INDICES)
+            slot_floats += meshTriangleIndexCapacity(IMG_WIDTH, IMG_HEIGHT);
+        for (int i = 0; i < kinect_count; ++i)
+        {
+            kinect_views[i].vertices.create(slot_floats, dirty_tile_tolerance >= 0);
+            kinect_views[i].device->setVertexStream(&kinect_views[i].vertices);
+        }
+        cout << "Kinect vertices: "
+             << (kinect_views[0].vertices.isPersistent() ? "persistent mapped buffer"
+                                                          : "buffer uploads")
+             << endl;
+    }
 
     // Create textures for each eye, and framebuffers for drawing to the textures.
-    glGenTextures(2, eye_tex);
-    glGenFramebuffers(2, frame_buffers);
+    // With single pass stereo both eyes share one double width texture.
+    int targets = single_pass_stereo ? 1 : 2;
+    unsigned target_w = single_pass_stereo ? 2 * tex_w : tex_w;
+    glGenTextures(targets, eye_tex);
+    glGenFramebuffers(targets, frame_buffers);
     GLuint render_buffers[2];
-    glGenRenderbuffers(2, render_buffers);
+    glGenRenderbuffers(targets, render_buffers);
 
     // For position tracking.
     ovrHmd_ConfigureTracking(hmd, ovrTrackingCap_Orientation |
                                   ovrTrackingCap_MagYawCorrection |
                                   ovrTrackingCap_Position, 0);
-    // Configure OVR rendering.
-    ovrGLConfig apiConfig;
-    apiConfig.OGL.Header.API = ovrRenderAPI_OpenGL;
-    apiConfig.OGL.Header.BackBufferSize = OVR::Sizei(hmd->Resolution.w,
-                                                     hmd->Resolution.h);
-    apiConfig.OGL.Header.Multisample = 1;
-    apiConfig.OGL.Disp = NULL;
-
-    ovrHmd_ConfigureRendering(hmd,
-                              &apiConfig.Config,
-                              hmd->DistortionCaps,
-                              hmd->DefaultEyeFov,
-                              eyeRenderDesc);
-
-    // Set up render textures for each eye, and pass information to LibOVR.
-    for(int eye = 0; eye < 2; ++eye)
+
+    if (bench_frames)
+    {
+        // Benchmarks have no window to distort into, only need the eyes' fov
+        // and offsets.
+        for(int eye = 0; eye < ovrEye_Count; ++eye)
+            eyeRenderDesc[eye] = ovrHmd_GetRenderDesc(hmd, ovrEyeType(eye),
+                                                      hmd->DefaultEyeFov[eye]);
+    }
+    else
+    {
+        // Configure OVR rendering.
+        ovrGLConfig apiConfig;
+        apiConfig.OGL.Header.API = ovrRenderAPI_OpenGL;
+        apiConfig.OGL.Header.BackBufferSize = OVR::Sizei(hmd->Resolution.w,
+                                                         hmd->Resolution.h);
+        apiConfig.OGL.Header.Multisample = 1;
+        apiConfig.OGL.Disp = NULL;
+
+        ovrHmd_ConfigureRendering(hmd,
+                                  &apiConfig.Config,
+                                  hmd->DistortionCaps,
+                                  hmd->DefaultEyeFov,
+                                  eyeRenderDesc);
+    }
+
+    // Set up render textures, and pass information to LibOVR.
+    for(int target = 0; target < targets; ++target)
     {
         // Make empty texture with correct size.
-        glBindTexture(GL_TEXTURE_2D, eye_tex[eye]);
+        glBindTexture(GL_TEXTURE_2D, eye_tex[target]);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tex_w, tex_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, target_w, tex_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 
         // Attach texture to render buffer.
-        glBindFramebuffer(GL_FRAMEBUFFER, frame_buffers[eye]);
-        glBindRenderbuffer(GL_RENDERBUFFER, render_buffers[eye]);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, tex_w, tex_h);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, eye_tex[eye], 0);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, render_buffers[eye]);
+        glBindFramebuffer(GL_FRAMEBUFFER, frame_buffers[target]);
+        glBindRenderbuffer(GL_RENDERBUFFER, render_buffers[target]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, target_w, tex_h);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, eye_tex[target], 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, render_buffers[target]);
+    }
 
+    for(int eye = 0; eye < 2; ++eye)
+    {
         // Give texture handles to LibOVR.
+        // Side by side, each eye uses its half of the shared texture.
+        int target = single_pass_stereo ? 0 : eye;
+        int viewport_x = single_pass_stereo ? eye * tex_w : 0;
         eyeTextures[eye].OGL.Header.API = ovrRenderAPI_OpenGL;
-        eyeTextures[eye].OGL.Header.TextureSize = OVR::Sizei(tex_w, tex_h);
-        eyeTextures[eye].OGL.Header.RenderViewport = OVR::Recti(0, 0, tex_w, tex_h);
-        eyeTextures[eye].OGL.TexId = eye_tex[eye];
+        eyeTextures[eye].OGL.Header.TextureSize = OVR::Sizei(target_w, tex_h);
+        eyeTextures[eye].OGL.Header.RenderViewport = OVR::Recti(viewport_x, 0, tex_w, tex_h);
+        eyeTextures[eye].OGL.TexId = eye_tex[target];
     }
 
     // Bind default texture and frame buffers for safety.
@@ -686,34 +2668,8 @@ void InitGL(unsigned int tex_w, unsigned int tex_h)
     glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
 
     glEnable(GL_DEPTH_TEST);
-}
-
-
-// Generate index array for triangle strip assuming every pixel is a vertex
-void makeIndexArray()
-{
-    unsigned height = IMG_HEIGHT/2; // Only using every other pixel in depth image.
-    unsigned width = IMG_WIDTH/2;   // Only using every other pixel in depth image.
-
-    for( unsigned yy = 0; yy < height-1; ++yy ) {
-        for( unsigned xx = 0; xx < width-1; ++xx ) {
 
-            unsigned x;
-            if( yy%2 == 1 ) x = width - xx - 1; // Odd rows go backwards
-            else x = xx;                        // Even rows
-            
-            // Push back vertical pairs of vertices.
-            indices.push_back(yy * width + x);
-            indices.push_back((yy+1) * width + x);
-        }
-        
-        // Only add one at the end of each row,
-        // the start of the next row will add the other.
-        if( yy%2 == 0 )
-            indices.push_back((yy * width) + (width - 1));
-        else
-            indices.push_back(yy * width);
-    }
+    createRoom();
 }
 
 
@@ -751,8 +2707,6 @@ void *gl_threadfunc(void *arg)
         exit(0);
     }
 
-    makeIndexArray();
-
     // Initialize glut and create window with oculus HMD display size
     glutInit(&g_argc, g_argv);
     glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_ALPHA | GLUT_DEPTH);
@@ -779,22 +2733,612 @@ void *gl_threadfunc(void *arg)
 }
 
 
+// Bytes handed to the GPU for Kinect frames.
+struct UploadBytes {
+    uint64_t rgb, depth, vertices;
+};
+
+UploadBytes uploadedBytes()
+{
+    UploadBytes bytes;
+    bytes.rgb = bytes.vertices = 0;
+    bytes.depth = depth_upload_bytes;
+    for (int i = 0; i < kinect_count; ++i)
+    {
+        bytes.rgb += kinect_views[i].rgb.uploadBytes();
+        bytes.vertices += kinect_views[i].vertices.streamedBytes() +
+                          kinect_views[i].fused_upload_bytes;
+    }
+    return bytes;
+}
+
+
+// Writes benchmark results as JSON to bench_report_path. Stage timings
+// are every thread's profiler timings that started after bench_start.
+// Returns false if the report could not be written.
+bool writeBenchReport(uint64_t bench_start, uint64_t bench_nanos,
+                      const UploadBytes &start_bytes, unsigned start_frames,
+                      unsigned start_rendered)
+{
+    FILE *file = fopen(bench_report_path.c_str(), "w");
+    if (!file)
+        return false;
+
+    double seconds = bench_nanos / 1e9;
+    fprintf(file, "{\n");
+    fprintf(file, "  \"frames\": %u,\n", bench_frames);
+    fprintf(file, "  \"seconds\": %.6f,\n", seconds);
+    fprintf(file, "  \"fps\": %.3f,\n", bench_frames / seconds);
+    fprintf(file, "  \"paced\": %s,\n", pace_frames ? "true" : "false");
+    fprintf(file, "  \"rendered_frames\": %u,\n", rendered_frames - start_rendered);
+    fprintf(file, "  \"kinects\": %d,\n", kinect_count);
+    fprintf(file, "  \"pool_threads\": %d,\n", pool_threads);
+    fprintf(file, "  \"kinect_frames\": %u,\n", totalKinectFrames());
+    fprintf(file, "  \"kinect_fps\": %.3f,\n", (totalKinectFrames() - start_frames) / seconds);
+    fprintf(file, "  \"source\": \"%s\",\n", replay_paths.empty() ? "synthetic" : "replay");
+    fprintf(file, "  \"stride\": %u,\n", mesh_stride);
+    fprintf(file, "  \"points\": %s,\n",
+            kinect_views[0].device->getDisplayMode() == KinectDevice::POINTS || lod_points
+            ? "true" : "false");
+    fprintf(file, "  \"point_size\": %.2f,\n", point_size);
+    fprintf(file, "  \"single_pass\": %s,\n", single_pass_stereo ? "true" : "false");
+    fprintf(file, "  \"gpu_unproject\": %s,\n", gpu_unproject ? "true" : "false");
+    fprintf(file, "  \"culling\": \"%s\",\n",
+            mesh_culling == CULL_COMPACT_INDICES ? "indices" :
+            mesh_culling == CULL_NAN_VERTICES ? "nan" : "gs");
+    fprintf(file, "  \"filter\": %s,\n", filter_depth ? "true" : "false");
+    fprintf(file, "  \"fill_holes\": \"%s\",\n",
+            hole_filling == FILL_CPU ? "cpu" : hole_filling == FILL_GPU ? "gpu" : "none");
+    fprintf(file, "  \"dirty_tile_tolerance\": %d,\n", dirty_tile_tolerance);
+    fprintf(file, "  \"fusion_voxel_size\": %.4f,\n", fuse_depth ? fusion_voxel_size : 0.0f);
+
+    // Percentiles of each stage on each thread.
+    fprintf(file, "  \"stages\": [");
+    bool first = true;
+    vector<frame_profiler::event> events;
+    for (int track = 0; track < frame_profiler::trackCount(); ++track)
+    {
+        const char *thread = frame_profiler::trackName(track);
+        frame_profiler::trackEvents(track, events);
+
+        map<string, latency_histogram> stages;
+        for (size_t i = 0; i < events.size(); ++i)
+            if (events[i].start >= bench_start)
+                stages[events[i].name].add(events[i].duration / 1000);
+
+        for (map<string, latency_histogram>::const_iterator stage = stages.begin();
+             stage != stages.end(); ++stage)
+        {
+            const latency_histogram &histogram = stage->second;
+            fprintf(file, "%s\n    {\"thread\": \"%s\", \"stage\": \"%s\", \"count\": %u, "
+                          "\"p50_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f}",
+                    first ? "" : ",", thread ? thread : "thread", stage->first.c_str(),
+                    histogram.count(), histogram.percentile(0.50) / 1000.0,
+                    histogram.percentile(0.99) / 1000.0, histogram.max() / 1000.0);
+            first = false;
+        }
+    }
+    fprintf(file, "\n  ],\n");
+
+    UploadBytes bytes = uploadedBytes();
+    bytes.rgb -= start_bytes.rgb;
+    bytes.depth -= start_bytes.depth;
+    bytes.vertices -= start_bytes.vertices;
+    fprintf(file, "  \"bytes_uploaded\": {\"rgb\": %llu, \"depth\": %llu, "
+                  "\"vertices\": %llu, \"total\": %llu}\n",
+            (unsigned long long)bytes.rgb, (unsigned long long)bytes.depth,
+            (unsigned long long)bytes.vertices,
+            (unsigned long long)(bytes.rgb + bytes.depth + bytes.vertices));
+    fprintf(file, "}\n");
+    return fclose(file) == 0;
+}
+
+
+// True once every Kinect has geometry on the GPU to draw.
+bool kinectGeometryDrawn()
+{
+    for (int i = 0; i < kinect_count; ++i)
+        if (kinect_views[i].vertex_count == 0)
+            return false;
+    return true;
+}
+
+
+// Renders bench_frames frames offscreen as fast as possible, then writes
+// the report and exits. A debug DK2 stands in for the Rift, so there is no
+// HMD, window or distortion pass; frames are rendered into the eye textures
+// of a headless OpenGL context.
+void *bench_threadfunc(void *arg)
+{
+    cout << "Benchmark thread" << endl;
+
+    // Initialize Oculus VR library. Works without the Oculus service.
+    if( !ovr_Initialize() )
+    {
+        cout<< "Failed to Initialize OVR" << endl;
+        exit(1);
+    }
+
+    hmd = ovrHmd_CreateDebug(ovrHmd_DK2);
+    if( !hmd )
+    {
+        cerr << "Failed to create debug HMD." << endl;
+        ovr_Shutdown();
+        exit(1);
+    }
+
+    headless_gl context;
+    if (!context.create())
+    {
+        cerr << "Failed to create a headless OpenGL context." << endl;
+        ovrHmd_Destroy(hmd);
+        ovr_Shutdown();
+        exit(1);
+    }
+
+    texture_w = hmd->Resolution.w/2;
+    texture_h = hmd->Resolution.h;
+
+    InitGL(texture_w, texture_h);
+
+    // Depth frames are dropped until InitGL is done. Draw untimed frames
+    // until every Kinect's geometry is on the GPU, so every timed frame
+    // draws it. A fused mesh only comes after the first few depth frames.
+    const uint64_t WARM_UP_NANOS = 10000000000ull;
+    uint64_t warm_up_end = frame_profiler::nanos() + WARM_UP_NANOS;
+    while (!kinectGeometryDrawn() && frame_profiler::nanos() < warm_up_end)
+    {
+        DrawGLScene();
+        usleep(1000);
+    }
+    if (!kinectGeometryDrawn())
+        cerr << "Not every Kinect had geometry to draw before the benchmark." << endl;
+
+    UploadBytes start_bytes = uploadedBytes();
+    unsigned start_frames = totalKinectFrames();
+    unsigned start_rendered = rendered_frames;
+    uint64_t start = frame_profiler::nanos();
+    for (unsigned frame = 0; frame < bench_frames; ++frame)
+        DrawGLScene();
+    uint64_t elapsed = frame_profiler::nanos() - start;
+
+    if (GLenum err = glGetError())
+        cerr << "OpenGL ERROR: " << gluErrorString(err) << endl;
+
+    bool written = writeBenchReport(start, elapsed, start_bytes, start_frames, start_rendered);
+    if (written)
+        cout << bench_frames << " frames in " << elapsed / 1e9 << " seconds, "
+             << bench_frames / (elapsed / 1e9) << " fps. Wrote report to "
+             << bench_report_path << endl;
+    else
+        cerr << "Failed to write benchmark report to " << bench_report_path << endl;
+
+    stopKinects();
+    context.destroy();
+    ovrHmd_Destroy(hmd);
+    ovr_Shutdown();
+    exit(written ? 0 : 1);
+
+    return NULL;
+}
+
+
+// Prints the command line options, returns false for parseArguments.
+bool printUsage(const char *program)
+{
+    cerr << "Usage: " << program << " [--stride 1|2|4|8] [--lod] [--single-pass]"
+         << " [--gpu-unproject] [--cull gs|indices|nan]"
+         << " [--points] [--point-size SAMPLES] [--keep-invalid-points]"
+         << " [--filter] [--fill-holes cpu|gpu] [--dirty-tiles TOLERANCE]"
+         << " [--threads N] [--pace]"
+         << " [--fuse [--voxel-size METERS]]"
+         << " [--kinects N] [--extrinsics FILE]"
+         << " [--record FILE | --replay FILE... [--replay-fast]]"
+         << " [--bench FRAMES [--bench-report FILE]]"
+         << " [--trace FILE]" << endl;
+    return false;
+}
+
+
+// Reads text as a whole decimal integer. False if there is anything else
+// in it, or it doesn't fit.
+bool parseInt(const char *text, int &value)
+{
+    char *end;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE ||
+        parsed < std::numeric_limits<int>::min() || parsed > std::numeric_limits<int>::max())
+        return false;
+    value = int(parsed);
+    return true;
+}
+
+
+// Reads text as a whole decimal number. False if there is anything else in it.
+bool parseFloat(const char *text, float &value)
+{
+    char *end;
+    errno = 0;
+    double parsed = strtod(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed != parsed)
+        return false;
+    value = float(parsed);
+    return true;
+}
+
+
+// Reads command line options into globals.
+// Returns false if the command line is not understood.
+bool parseArguments(int argc, char **argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+
+        if (arg == "--stride" && i + 1 < argc)
+        {
+            int stride;
+            if (!parseInt(argv[++i], stride) ||
+                (stride != 1 && stride != 2 && stride != 4 && stride != 8))
+            {
+                cerr << "Mesh stride must be 1, 2, 4 or 8." << endl;
+                return printUsage(argv[0]);
+            }
+            user_mesh_stride = mesh_stride = stride;
+        }
+        else if (arg == "--lod")
+        {
+            lod_enabled = true;
+        }
+        else if (arg == "--single-pass")
+        {
+            single_pass_stereo = true;
+        }
+        else if (arg == "--gpu-unproject")
+        {
+            gpu_unproject = true;
+        }
+        else if (arg == "--cull" && i + 1 < argc)
+        {
+            string culling = argv[++i];
+            if (culling == "gs")
+                mesh_culling = CULL_GEOMETRY_SHADER;
+            else if (culling == "indices")
+                mesh_culling = CULL_COMPACT_INDICES;
+            else if (culling == "nan")
+                mesh_culling = CULL_NAN_VERTICES;
+            else
+            {
+                cerr << "Culling must be gs, indices or nan." << endl;
+                return false;
+            }
+        }
+        else if (arg == "--filter")
+        {
+            filter_depth = true;
+        }
+        else if (arg == "--fill-holes" && i + 1 < argc)
+        {
+            string filling = argv[++i];
+            if (filling == "cpu")
+                hole_filling = FILL_CPU;
+            else if (filling == "gpu")
+                hole_filling = FILL_GPU;
+            else
+            {
+                cerr << "Hole filling must be cpu or gpu." << endl;
+                return false;
+            }
+        }
+        else if (arg == "--points")
+        {
+            start_with_points = true;
+        }
+        else if (arg == "--point-size" && i + 1 < argc)
+        {
+            if (!parseFloat(argv[++i], point_size) || point_size < .5 || point_size > 4)
+            {
+                cerr << "Point size must be .5 to 4 depth samples." << endl;
+                return printUsage(argv[0]);
+            }
+        }
+        else if (arg == "--keep-invalid-points")
+        {
+            cull_invalid_points = false;
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            if (!parseInt(argv[++i], pool_threads) ||
+                pool_threads < 1 || pool_threads > MAX_POOL_THREADS)
+            {
+                cerr << "Threads must be 1 to " << MAX_POOL_THREADS << "." << endl;
+                return printUsage(argv[0]);
+            }
+        }
+        else if (arg == "--pace")
+        {
+            pace_frames = true;
+        }
+        else if (arg == "--fuse")
+        {
+            fuse_depth = true;
+        }
+        else if (arg == "--voxel-size" && i + 1 < argc)
+        {
+            if (!parseFloat(argv[++i], fusion_voxel_size) ||
+                fusion_voxel_size < .004 || fusion_voxel_size > .1)
+            {
+                cerr << "Voxel size must be .004 to .1 meters." << endl;
+                return printUsage(argv[0]);
+            }
+        }
+        else if (arg == "--dirty-tiles" && i + 1 < argc)
+        {
+            if (!parseInt(argv[++i], dirty_tile_tolerance) || dirty_tile_tolerance < 0)
+            {
+                cerr << "Dirty tile tolerance must be a whole number, 0 or more." << endl;
+                return printUsage(argv[0]);
+            }
+        }
+        else if (arg == "--record" && i + 1 < argc)
+        {
+            record_path = argv[++i];
+        }
+        else if (arg == "--replay" && i + 1 < argc)
+        {
+            replay_paths.push_back(argv[++i]);
+        }
+        else if (arg == "--kinects" && i + 1 < argc)
+        {
+            if (!parseInt(argv[++i], kinect_count) ||
+                kinect_count < 1 || kinect_count > MAX_KINECTS)
+            {
+                cerr << "Number of Kinects must be 1 to " << MAX_KINECTS << "." << endl;
+                return printUsage(argv[0]);
+            }
+        }
+        else if (arg == "--extrinsics" && i + 1 < argc)
+        {
+            extrinsics_path = argv[++i];
+        }
+        else if (arg == "--replay-fast")
+        {
+            replay_fast = true;
+        }
+        else if (arg == "--bench" && i + 1 < argc)
+        {
+            int frames;
+            if (!parseInt(argv[++i], frames) || frames < 1)
+            {
+                cerr << "Benchmark needs a whole number of frames, at least one." << endl;
+                return printUsage(argv[0]);
+            }
+            bench_frames = frames;
+        }
+        else if (arg == "--bench-report" && i + 1 < argc)
+        {
+            bench_report_path = argv[++i];
+        }
+        else if (arg == "--trace" && i + 1 < argc)
+        {
+            trace_path = argv[++i];
+            trace_at_exit = true;
+        }
+        else
+        {
+            return printUsage(argv[0]);
+        }
+    }
+
+    if (!record_path.empty() && !replay_paths.empty())
+    {
+        cerr << "Cannot record and replay at the same time." << endl;
+        return false;
+    }
+
+    // One recording per Kinect, unless more Kinects are asked for.
+    if ((int)replay_paths.size() > MAX_KINECTS)
+    {
+        cerr << "Cannot replay more than " << MAX_KINECTS << " recordings." << endl;
+        return false;
+    }
+    kinect_count = max(kinect_count, (int)replay_paths.size());
+
+    if (!record_path.empty() && kinect_count > 1)
+    {
+        cerr << "Can only record one Kinect." << endl;
+        return false;
+    }
+
+    if (gpu_unproject && mesh_culling == CULL_COMPACT_INDICES)
+    {
+        cerr << "Compacted indices need vertices from the depth thread,"
+             << " they don't work with --gpu-unproject." << endl;
+        return false;
+    }
+
+    if ((hole_filling == FILL_CPU && gpu_unproject) ||
+        (hole_filling == FILL_GPU && !gpu_unproject))
+    {
+        cerr << "Hole filling on the cpu needs vertices from the depth thread,"
+             << " on the gpu it needs --gpu-unproject." << endl;
+        return false;
+    }
+
+    if (dirty_tile_tolerance >= 0 && (gpu_unproject || mesh_culling == CULL_NAN_VERTICES))
+    {
+        cerr << "Dirty tiles need vertices from the depth thread that are"
+             << " kept between frames, they don't work with --gpu-unproject"
+             << " or --cull nan." << endl;
+        return false;
+    }
+
+    if (fuse_depth && (gpu_unproject || hole_filling != FILL_NONE || dirty_tile_tolerance >= 0))
+    {
+        cerr << "Fusion needs depth on the depth thread, and replaces the mesh"
+             << " of each frame, it doesn't work with --gpu-unproject,"
+             << " --fill-holes or --dirty-tiles." << endl;
+        return false;
+    }
+
+    if (!record_path.empty() && bench_frames)
+    {
+        cerr << "Cannot record while benchmarking." << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+// Reads one "x y z yaw pitch roll" line per Kinect from extrinsics_path
+// into kinect_views, in meters and degrees. Blank lines and lines starting
+// with # are skipped. Returns false if the file can not be read or a line
+// is not understood.
+bool loadExtrinsics()
+{
+    FILE *file = fopen(extrinsics_path.c_str(), "r");
+    if (!file)
+        return false;
+
+    bool understood = true;
+    char line[256];
+    int kinect = 0;
+    while (kinect < kinect_count && fgets(line, sizeof(line), file))
+    {
+        char first;
+        if (sscanf(line, " %c", &first) != 1 || first == '#')
+            continue;
+
+        float x, y, z, yaw, pitch, roll;
+        if (sscanf(line, "%f %f %f %f %f %f", &x, &y, &z, &yaw, &pitch, &roll) != 6)
+        {
+            understood = false;
+            break;
+        }
+        kinect_views[kinect++].extrinsic =
+            Matrix4f::Translation(x, y, z) *
+            Matrix4f::RotationY(OVR::DegreeToRad(yaw)) *
+            Matrix4f::RotationX(OVR::DegreeToRad(pitch)) *
+            Matrix4f::RotationZ(OVR::DegreeToRad(roll));
+    }
+    fclose(file);
+    return understood;
+}
+
+
+// Creates Kinect number index: a replayed recording, made up frames for
+// benchmarks, or a live Kinect. Returns NULL if it could not be created.
+KinectDevice *createKinect(int index)
+{
+    if (!replay_paths.empty())
+    {
+        const string &path = replay_paths[index % replay_paths.size()];
+        ReplayDevice *replay = new ReplayDevice(path, !replay_fast);
+        if (replay->isOpen())
+            return replay;
+        cerr << "Failed to open recording " << path << endl;
+        delete replay;
+        return NULL;
+    }
+
+    if (bench_frames)
+    {
+        // Benchmark without a Kinect.
+        return new SyntheticDevice(!replay_fast);
+    }
+
+    MyFreenectDevice *live = &freenectContext().createDevice<MyFreenectDevice>(index);
+    if (live && !record_path.empty())
+    {
+        if (recorder.open(record_path, IMG_WIDTH, IMG_HEIGHT))
+        {
+            live->setRecorder(&recorder);
+            recording_device = live;
+        }
+        else
+            cerr << "Failed to open " << record_path << " for recording." << endl;
+    }
+    return live;
+}
+
+
 int main(int argc, char **argv)
 {
-    device = &freenect.createDevice<MyFreenectDevice>(0);
-    if( device )
+    if (!parseArguments(argc, argv))
+        return 1;
+
+    if (trace_at_exit)
+        atexit(writeTrace);
+
+    // Kinects are placed where the extrinsics file says, or by default
+    // where a single Kinect has always been.
+    for (int i = 0; i < kinect_count; ++i)
+        kinect_views[i].extrinsic = Matrix4f::Translation(DEFAULT_KINECT_POSITION);
+    if (!extrinsics_path.empty() && !loadExtrinsics())
+    {
+        cerr << "Failed to read Kinect extrinsics from " << extrinsics_path << endl;
+        return 1;
+    }
+
+    for (int i = 0; i < kinect_count; ++i)
+    {
+        kinect_views[i].device = createKinect(i);
+        if (!kinect_views[i].device)
+        {
+            cerr << "Failed to create Kinect Device " << i << "." << endl;
+            return 1;
+        }
+    }
+
+    // Each Kinect converts depth on a worker of its own, leaving the first
+    // core to the renderer. Recordings and made up frames played as fast
+    // as possible wait for their worker, so they drop no frames.
+    static const char *worker_names[MAX_KINECTS] = {
+        "depth worker 0", "depth worker 1", "depth worker 2", "depth worker 3"
+    };
+    int cores = depth_worker::coreCount();
+
+    // Stages spread over every core, split evenly between the Kinects.
+    // Each Kinect's worker is one of its own pool's threads.
+    if (pool_threads == 0)
+        pool_threads = min(cores, MAX_POOL_THREADS);
+    int kinect_threads = max(pool_threads / kinect_count, 1);
+
+    bool can_wait = !replay_paths.empty() || bench_frames;
+    for (int i = 0; i < kinect_count; ++i)
     {
+        KinectDevice *device = kinect_views[i].device;
+        device->setMeshStride(mesh_stride);
+        if (start_with_points)
+            device->toggleDisplayMode();
+        device->setRawDepthOutput(gpu_unproject);
+        device->setMeshCulling(mesh_culling);
+        device->setDepthFilter(filter_depth);
+        device->setHoleFilling(hole_filling == FILL_CPU);
+        if (dirty_tile_tolerance >= 0)
+            device->setDirtyTiles(dirty_tile_tolerance);
+        if (kinect_threads > 1)
+            device->setWorkerPool(kinect_threads - 1);
+        if (fuse_depth)
+            device->setFusion(fusion_voxel_size);
+        device->startWorker((i + 1) % cores, worker_names[i], can_wait && replay_fast);
+
         // Start Kinect processing.
         device->startVideo();
         device->startDepth();
-
-        // Start Rendering in separate thread.
-        gl_threadfunc(NULL);
     }
+    cout << kinect_count << " Kinect" << (kinect_count > 1 ? "s" : "")
+         << ", depth workers on " << cores << " cores, stages split over "
+         << kinect_threads << " thread" << (kinect_threads > 1 ? "s" : "")
+         << " per Kinect" << endl;
+
+    // Start Rendering in separate thread.
+    if (bench_frames)
+        bench_threadfunc(NULL);
     else
-    {
-        cerr << "Failed to create Freenect Device." << endl;
-    }
+        gl_threadfunc(NULL);
 
     return 0;
 }